@@ -0,0 +1,813 @@
+/*
+ * An encrypted and authenticated UART link using the AES256 hardware accelerator
+ *
+ * Everything the other UART programs send with use_9600_baud() can be read (and
+ * changed) by anybody connected to the wires. This program sends each message as a
+ * "secure frame":
+ *
+ *   0xA5 | length | message number (4 bytes) | encrypted message | tag (8 bytes)
+ *
+ *  - The message is ENCRYPTED with AES-256 in CTR (counter) mode. AES turns a 16 byte
+ *    "counter block" (message number + block number) into 16 random looking bytes, and
+ *    these are XORed with the message. The receiver does exactly the same thing to get
+ *    the message back. The message number goes up for every frame, so the same counter
+ *    block is never used twice with the same key.
+ *
+ *    That only holds if the number survives a reset AND loading a new program - the
+ *    keys are the same in every build. #pragma PERSISTENT would not do: every download
+ *    writes the variable's starting value back, the numbers start again at 0 and the
+ *    key stream repeats. So the number is kept in Information memory B (0x1900, see
+ *    struct link_state), which is not part of the program image. CCS leaves it alone as
+ *    long as the download option stays on "Erase main memory only" (Debug -> MSP430
+ *    Properties -> Download Options). If it is ever erased, change the keys as well.
+ *
+ *  - The TAG is an AES-CMAC of everything before it, using a second key. The receiver
+ *    works it out again; if anybody changed even one bit on the wire the tags will not
+ *    match and the frame is thrown away.
+ *
+ * verify_secure_frame() is the receiving side. It works the tag out again and compares
+ * it with tags_match(), which always looks at every byte - a compare that stops at the
+ * first wrong byte takes longer the more bytes are right, and an attacker can time
+ * that to find a good tag one byte at a time. Only if the tag is right is the message
+ * decrypted (CTR again, with the message number from the header).
+ *
+ * A frame that was recorded and sent again later would pass the tag check too, so the
+ * receiver also keeps (in the same Information memory) the lowest message number it
+ * will still take. A good frame must have a number at least that big, and moves it up
+ * to its number + 1 - every message is accepted once at most.
+ *
+ * AES on a 16-bit CPU in software takes thousands of cycles per block, so we use the
+ * AES256 module. For the CTR part, DMA channel 1 feeds the counter blocks into AESADIN
+ * and DMA channel 0 takes the answers out of AESADOUT, so the CPU just waits for the
+ * DMA to finish (AES trigger 0 and 1 are DMA triggers 11 and 12 on the FR6989).
+ *
+ * KEYS
+ * ----
+ * Both keys are in the .ipe_const section, and the only function that reads them,
+ * aes_load_key(), is in the .ipe section. When IP Encapsulation is turned on in the
+ * project properties (General -> MPU -> Enable IP Encapsulation), the linker command file
+ * protects these sections so that nothing else (not even the debugger) can read the keys.
+ * The keys below are examples only - every device should have its own.
+ *
+ * SOFTWARE MODEL AND BENCHMARK
+ * ----------------------------
+ * soft_encrypt_block() is a plain C AES-256 (FIPS-197), written to be easy to follow rather
+ * than fast, so it can be checked on a PC. At start-up it is checked with the FIPS-197
+ * example, and the hardware is checked against it for ECB, CTR and CMAC (the CMAC with
+ * the NIST SP 800-38B example). model_ok is 1 if everything matched.
+ *
+ * The frame built for the benchmark is then looped back through verify_secure_frame().
+ * One byte of the header, of the cipher text and of the tag is changed in turn, and
+ * each time the frame must be thrown away. Then the real frame must be accepted and
+ * give back the message, and the same frame again must be thrown away (a replay).
+ * frame_ok is 1 if all of that happened. The green LED needs both.
+ *
+ * The benchmark times how long it takes to build one secure frame of FRAME_SIZE bytes,
+ * and how long it takes to just copy the same bytes into a plain frame (Timer1 counts
+ * SMCLK = MCLK = 8MHz). These are turned into bytes per second in secure_bytes_per_second
+ * and plain_bytes_per_second. At 9600 baud the line itself only carries 960 bytes per
+ * second, so as long as both numbers are much bigger than that, encryption does not slow
+ * the link down - only the extra 14 bytes of each frame do.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE                          // Required to use inputs and outputs
+#define SMCLK                   0x0200                          // Timer_A SMCLK source
+#define CONTINUOUS              0x0020                          // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080                          // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                            // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                            // Value required to use 9600 baud
+#define CLK_MOD                 0x4911                          // uC will "clean up" clock signal
+#define CPU_HZ                  8000000                         // MCLK after select_clock_signals()
+
+#define BLOCK_SIZE              16                              // AES works on 16 bytes at a time
+#define KEY_SIZE                32                              // AES-256 key
+#define ROUND_KEY_SIZE          240                             // 15 round keys of 16 bytes
+#define DMA_BLOCKS              4                               // Counter blocks per DMA burst
+#define FRAME_SIZE              64                              // Message bytes per frame
+#define TAG_SIZE                8                               // Bytes of the CMAC sent
+#define FRAME_START             0xA5                            // First byte of every frame
+#define HEADER_SIZE             6                               // Start, length, message number
+#define LINK_STATE_ADDRESS      0x1900                          // Information memory B - not in the image
+#define LINK_STATE_VALID        0x5EC1                          // link_state has been set up
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                                // Assigns uC clock signals
+void assign_pins_to_uart(void);                                 // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                                       // UART operates at 9600 bits per second
+void send_byte(unsigned char data);                             // Polled UART transmit
+
+void aes_load_key(const unsigned char *key);                    // Key into the AES256 module
+void aes_encrypt_block(const unsigned char *in, unsigned char *out);
+void aes_encrypt_blocks_dma(const unsigned char *in, unsigned char *out, unsigned int blocks);
+void make_counter_block(unsigned long message_number, unsigned int block_number, unsigned char *block);
+void ctr_crypt(unsigned long message_number, unsigned char *data, unsigned int length);
+void double_block(unsigned char *block);                        // CMAC sub-key step
+void cmac(void (*encrypt)(const unsigned char *, unsigned char *),
+          const unsigned char *data, unsigned int length, unsigned char *tag);
+unsigned int build_secure_frame(const unsigned char *message, unsigned int length, unsigned char *frame);
+unsigned int build_plain_frame(const unsigned char *message, unsigned int length, unsigned char *frame);
+unsigned char verify_secure_frame(const unsigned char *frame, unsigned int size,
+                                  unsigned char *message, unsigned int *length);   // 0 - thrown away
+unsigned char tags_match(const unsigned char *a, const unsigned char *b);          // Constant time
+unsigned char check_loopback(unsigned int size);                // frame[] accepted once, tampered ones not
+void link_state_init(void);                                     // First start ever - numbers from 0
+
+unsigned char xtime(unsigned char value);                       // Software model
+void soft_set_key(const unsigned char *key);
+void soft_encrypt_block(const unsigned char *in, unsigned char *out);
+unsigned char same(const unsigned char *a, const unsigned char *b, unsigned int length);
+unsigned char check_model(void);
+
+// **************************************************************
+// Keys - in IP Encapsulated FRAM, only readable from .ipe code
+// **************************************************************
+#pragma DATA_SECTION(encrypt_key, ".ipe_const")
+const unsigned char encrypt_key[KEY_SIZE] =
+{
+    0x3A, 0x91, 0x5C, 0x07, 0xE2, 0x48, 0xB6, 0x1D, 0x7F, 0x20, 0xC4, 0x89, 0x53, 0xEE, 0x0B, 0x66,
+    0xA8, 0x15, 0xD3, 0x72, 0x4E, 0x9B, 0x01, 0xC7, 0x38, 0x6A, 0xF5, 0x2C, 0x90, 0x5D, 0xB1, 0x0E
+};
+
+#pragma DATA_SECTION(mac_key, ".ipe_const")
+const unsigned char mac_key[KEY_SIZE] =
+{
+    0x6D, 0x02, 0xB9, 0x47, 0x1E, 0xF3, 0x85, 0x5A, 0xC0, 0x39, 0x74, 0xAB, 0x16, 0xDF, 0x62, 0x08,
+    0x93, 0x4C, 0xE7, 0x21, 0xBD, 0x58, 0x0F, 0x96, 0x4A, 0xE1, 0x27, 0x7C, 0xD5, 0x33, 0x8E, 0x69
+};
+
+// Message numbers - in Information memory B, so loading a program does not reset them
+struct link_state
+{
+    unsigned int valid;                                         // LINK_STATE_VALID once set up
+    unsigned long next_number;                                  // Sender - never re-use a counter block
+    unsigned long lowest_accepted;                              // Receiver - anything lower is a replay
+};
+
+#define link_state              (*(volatile struct link_state *)LINK_STATE_ADDRESS)
+
+// AES S-box from FIPS-197
+const unsigned char sbox[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+// FIPS-197 appendix C.3 (AES-256)
+const unsigned char fips_key[KEY_SIZE] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+};
+const unsigned char fips_plain[BLOCK_SIZE] =
+{
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+const unsigned char fips_cipher[BLOCK_SIZE] =
+{
+    0x8E, 0xA2, 0xB7, 0xCA, 0x51, 0x67, 0x45, 0xBF, 0xEA, 0xFC, 0x49, 0x90, 0x4B, 0x49, 0x60, 0x89
+};
+
+// NIST SP 800-38B, AES-256 CMAC example with one block
+const unsigned char nist_key[KEY_SIZE] =
+{
+    0x60, 0x3D, 0xEB, 0x10, 0x15, 0xCA, 0x71, 0xBE, 0x2B, 0x73, 0xAE, 0xF0, 0x85, 0x7D, 0x77, 0x81,
+    0x1F, 0x35, 0x2C, 0x07, 0x3B, 0x61, 0x08, 0xD7, 0x2D, 0x98, 0x10, 0xA3, 0x09, 0x14, 0xDF, 0xF4
+};
+const unsigned char nist_message[BLOCK_SIZE] =
+{
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A
+};
+const unsigned char nist_tag[BLOCK_SIZE] =
+{
+    0x28, 0xA7, 0x02, 0x3F, 0x45, 0x2E, 0x8F, 0x82, 0xBD, 0x4B, 0xF2, 0x8D, 0x8C, 0x37, 0xC3, 0x5C
+};
+
+unsigned char round_keys[ROUND_KEY_SIZE];                       // Software model key schedule
+unsigned int counter_blocks[DMA_BLOCKS * BLOCK_SIZE / 2];       // Word aligned for the DMA
+unsigned int key_stream[DMA_BLOCKS * BLOCK_SIZE / 2];
+unsigned char message[FRAME_SIZE];
+unsigned char frame[HEADER_SIZE + FRAME_SIZE + TAG_SIZE];
+unsigned char received[FRAME_SIZE];                             // verify_secure_frame() output
+
+unsigned char model_ok;                                         // 1 if hardware matched the model
+unsigned char frame_ok;                                         // 1 if the loop-back test passed
+unsigned int secure_cycles;                                     // Cycles to build one secure frame
+unsigned int plain_cycles;                                      // Cycles to build one plain frame
+unsigned long secure_bytes_per_second;
+unsigned long plain_bytes_per_second;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned int i;
+    unsigned int length;
+    unsigned int start;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stops WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable pins
+
+    P1DIR = BIT0;                                               // Red LED - model did not match
+    P9DIR = BIT7;                                               // Green LED - model matched
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                                     // Assigns uC clock signals
+    assign_pins_to_uart();                                      // P4.2 is for TXD, P4.3 is for RXD
+    use_9600_baud();                                            // UART operates at 9600 bits per second
+
+    link_state_init();
+
+    model_ok = check_model();
+    if(model_ok == 0)
+    {
+        P1OUT = BIT0;
+        while(1);                                               // Never send with a broken AES
+    }
+
+    for(i = 0; i < FRAME_SIZE; i = i + 1)                       // Something to send
+    {
+        message[i] = (unsigned char)i;
+    }
+
+    // Benchmark
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;                        // 1 count = 1 MCLK cycle
+    start = TA1R;
+    build_plain_frame(message, FRAME_SIZE, frame);
+    plain_cycles = TA1R - start;
+    start = TA1R;
+    length = build_secure_frame(message, FRAME_SIZE, frame);
+    secure_cycles = TA1R - start;
+    TA1CTL = 0;
+
+    plain_bytes_per_second = ((unsigned long)CPU_HZ / plain_cycles) * FRAME_SIZE;
+    secure_bytes_per_second = ((unsigned long)CPU_HZ / secure_cycles) * FRAME_SIZE;
+
+    frame_ok = check_loopback(length);                          // Can the other end read it?
+    if(frame_ok)
+    {
+        P9OUT = BIT7;
+    }
+    else
+    {
+        P1OUT = BIT0;
+        while(1);
+    }
+
+    for(i = 0; i < length; i = i + 1)                           // Send the secure frame
+    {
+        send_byte(frame[i]);
+    }
+
+    while(1);
+}
+
+// ***************************************
+// AES256 module
+// ***************************************
+#pragma CODE_SECTION(aes_load_key, ".ipe")
+void aes_load_key(const unsigned char *key)
+{
+    unsigned char i;
+
+    AESACTL0 = AESSWRST;                                        // Start from a clean module
+    AESACTL0 = AESKL__256 | AESOP_0 | AESCM__ECB;               // 256-bit key, encrypt, one block at a time
+    for(i = 0; i < KEY_SIZE; i = i + 2)
+    {
+        AESAKEY = key[i] | ((unsigned int)key[i + 1] << 8);     // First byte goes in the low half
+    }
+    while((AESASTAT & AESKEYWR) == 0);                          // Wait for the whole key
+}
+
+void aes_encrypt_block(const unsigned char *in, unsigned char *out)
+{
+    unsigned char i;
+    unsigned int word;
+
+    for(i = 0; i < BLOCK_SIZE; i = i + 2)                       // 8 words in starts the encryption
+    {
+        AESADIN = in[i] | ((unsigned int)in[i + 1] << 8);
+    }
+    while(AESASTAT & AESBUSY);
+    for(i = 0; i < BLOCK_SIZE; i = i + 2)
+    {
+        word = AESADOUT;
+        out[i] = (unsigned char)word;
+        out[i + 1] = (unsigned char)(word >> 8);
+    }
+}
+
+void aes_encrypt_blocks_dma(const unsigned char *in, unsigned char *out, unsigned int blocks)
+{
+    AESACTL0 = AESACTL0 | AESCMEN;                              // AES module asks the DMA for data
+
+    DMACTL0 = DMA0TSEL_11 | DMA1TSEL_12;                        // AES trigger 0 and 1
+    __data20_write_long((unsigned long)&DMA0SA, (unsigned long)&AESADOUT);  // Channel 0 - answers out
+    __data20_write_long((unsigned long)&DMA0DA, (unsigned long)out);
+    __data20_write_long((unsigned long)&DMA1SA, (unsigned long)in);         // Channel 1 - blocks in
+    __data20_write_long((unsigned long)&DMA1DA, (unsigned long)&AESADIN);
+    DMA0SZ = blocks * (BLOCK_SIZE / 2);
+    DMA1SZ = blocks * (BLOCK_SIZE / 2);
+    DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_3 | DMAEN;    // One word per trigger
+    DMA1CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMAEN;
+
+    AESACTL1 = blocks;                                          // Writing the block count starts it all
+
+    while(DMA0CTL & DMAEN);                                     // DMAEN clears after the last answer
+    AESACTL0 = AESACTL0 & ~AESCMEN;
+}
+
+// ***************************************
+// CTR mode - the same call encrypts and decrypts
+// ***************************************
+void make_counter_block(unsigned long message_number, unsigned int block_number, unsigned char *block)
+{
+    unsigned char i;
+
+    block[0] = (unsigned char)(message_number >> 24);           // Big-endian, like the rest of the world
+    block[1] = (unsigned char)(message_number >> 16);
+    block[2] = (unsigned char)(message_number >> 8);
+    block[3] = (unsigned char)message_number;
+    for(i = 4; i < 14; i = i + 1)
+    {
+        block[i] = 0;
+    }
+    block[14] = (unsigned char)(block_number >> 8);
+    block[15] = (unsigned char)block_number;
+}
+
+void ctr_crypt(unsigned long message_number, unsigned char *data, unsigned int length)
+{
+    unsigned char *counters = (unsigned char *)counter_blocks;
+    unsigned char *stream = (unsigned char *)key_stream;
+    unsigned int block_number = 0;
+    unsigned int blocks;
+    unsigned int i;
+
+    aes_load_key(encrypt_key);
+
+    while(length > 0)
+    {
+        blocks = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;        // Blocks still to do...
+        if(blocks > DMA_BLOCKS)                                 // ...but only as many as fit
+        {
+            blocks = DMA_BLOCKS;
+        }
+        for(i = 0; i < blocks; i = i + 1)
+        {
+            make_counter_block(message_number, block_number + i, &counters[i * BLOCK_SIZE]);
+        }
+        aes_encrypt_blocks_dma(counters, stream, blocks);
+        block_number = block_number + blocks;
+
+        for(i = 0; (i < blocks * BLOCK_SIZE) && (length > 0); i = i + 1)
+        {
+            *data = *data ^ stream[i];
+            data = data + 1;
+            length = length - 1;
+        }
+    }
+}
+
+// ***************************************
+// CMAC (NIST SP 800-38B)
+// ***************************************
+void double_block(unsigned char *block)                         // Shift left 1 bit, fold the top bit back in
+{
+    unsigned char carry = block[0] & 0x80;
+    unsigned char i;
+
+    for(i = 0; i < BLOCK_SIZE - 1; i = i + 1)
+    {
+        block[i] = (block[i] << 1) | (block[i + 1] >> 7);
+    }
+    block[BLOCK_SIZE - 1] = block[BLOCK_SIZE - 1] << 1;
+    if(carry)
+    {
+        block[BLOCK_SIZE - 1] = block[BLOCK_SIZE - 1] ^ 0x87;
+    }
+}
+
+void cmac(void (*encrypt)(const unsigned char *, unsigned char *),
+          const unsigned char *data, unsigned int length, unsigned char *tag)
+{
+    unsigned char subkey[BLOCK_SIZE];
+    unsigned char x[BLOCK_SIZE];
+    unsigned int blocks;
+    unsigned int i;
+    unsigned int position;
+    unsigned char j;
+
+    for(j = 0; j < BLOCK_SIZE; j = j + 1)
+    {
+        x[j] = 0;
+    }
+    encrypt(x, subkey);                                         // L = AES(0)
+    double_block(subkey);                                       // K1
+    if((length == 0) || (length % BLOCK_SIZE))
+    {
+        double_block(subkey);                                   // K2 - last block needs padding
+    }
+
+    blocks = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if(blocks == 0)
+    {
+        blocks = 1;
+    }
+
+    for(i = 0; i < blocks - 1; i = i + 1)                       // All but the last block
+    {
+        for(j = 0; j < BLOCK_SIZE; j = j + 1)
+        {
+            x[j] = x[j] ^ *data;
+            data = data + 1;
+        }
+        encrypt(x, x);
+    }
+
+    position = (blocks - 1) * BLOCK_SIZE;                       // Last block, padded with 0x80 0x00...
+    for(j = 0; j < BLOCK_SIZE; j = j + 1)
+    {
+        if(position + j < length)
+        {
+            x[j] = x[j] ^ *data ^ subkey[j];
+            data = data + 1;
+        }
+        else if(position + j == length)
+        {
+            x[j] = x[j] ^ 0x80 ^ subkey[j];
+        }
+        else
+        {
+            x[j] = x[j] ^ subkey[j];
+        }
+    }
+    encrypt(x, tag);
+}
+
+// ***************************************
+// Frames
+// ***************************************
+unsigned int build_secure_frame(const unsigned char *message, unsigned int length, unsigned char *frame)
+{
+    unsigned char tag[BLOCK_SIZE];
+    unsigned long number = link_state.next_number;
+    unsigned int i;
+
+    link_state.next_number = number + 1;                        // Saved in FRAM BEFORE it is used
+
+    frame[0] = FRAME_START;
+    frame[1] = (unsigned char)length;
+    frame[2] = (unsigned char)(number >> 24);
+    frame[3] = (unsigned char)(number >> 16);
+    frame[4] = (unsigned char)(number >> 8);
+    frame[5] = (unsigned char)number;
+    for(i = 0; i < length; i = i + 1)
+    {
+        frame[HEADER_SIZE + i] = message[i];
+    }
+
+    ctr_crypt(number, &frame[HEADER_SIZE], length);             // Encrypt...
+
+    aes_load_key(mac_key);                                      // ...then MAC the header and cipher text
+    cmac(aes_encrypt_block, frame, HEADER_SIZE + length, tag);
+    for(i = 0; i < TAG_SIZE; i = i + 1)
+    {
+        frame[HEADER_SIZE + length + i] = tag[i];
+    }
+
+    return HEADER_SIZE + length + TAG_SIZE;
+}
+
+unsigned char verify_secure_frame(const unsigned char *frame, unsigned int size,
+                                  unsigned char *message, unsigned int *length)
+{
+    unsigned char tag[BLOCK_SIZE];
+    unsigned long number;
+    unsigned int i;
+
+    if((size < HEADER_SIZE + TAG_SIZE) || (frame[0] != FRAME_START) ||
+       (frame[1] > FRAME_SIZE) || (size != HEADER_SIZE + frame[1] + TAG_SIZE))
+    {
+        return 0;                                               // Not even the right shape
+    }
+    *length = frame[1];
+
+    aes_load_key(mac_key);                                      // Check first...
+    cmac(aes_encrypt_block, frame, HEADER_SIZE + *length, tag);
+    if(tags_match(tag, &frame[HEADER_SIZE + *length]) == 0)
+    {
+        return 0;
+    }
+
+    number = ((unsigned long)frame[2] << 24) | ((unsigned long)frame[3] << 16) |
+             ((unsigned long)frame[4] << 8) | frame[5];
+    if(number < link_state.lowest_accepted)                     // Seen it (or an older one) before
+    {
+        return 0;
+    }
+    link_state.lowest_accepted = number + 1;
+
+    for(i = 0; i < *length; i = i + 1)                          // ...then decrypt
+    {
+        message[i] = frame[HEADER_SIZE + i];
+    }
+    ctr_crypt(number, message, *length);
+    return 1;
+}
+
+unsigned char tags_match(const unsigned char *a, const unsigned char *b)
+{
+    unsigned char difference = 0;
+    unsigned char i;
+
+    for(i = 0; i < TAG_SIZE; i = i + 1)                         // No early exit - same time for any tag
+    {
+        difference = difference | (a[i] ^ b[i]);
+    }
+    return difference == 0;
+}
+
+unsigned int build_plain_frame(const unsigned char *message, unsigned int length, unsigned char *frame)
+{
+    unsigned int i;
+
+    frame[0] = FRAME_START;
+    frame[1] = (unsigned char)length;
+    for(i = 0; i < length; i = i + 1)
+    {
+        frame[2 + i] = message[i];
+    }
+    return 2 + length;
+}
+
+// ***************************************
+// Software model of AES-256 encryption
+// ***************************************
+unsigned char xtime(unsigned char value)                        // Multiply by 2 in AES arithmetic
+{
+    if(value & 0x80)
+    {
+        return (value << 1) ^ 0x1B;
+    }
+    return value << 1;
+}
+
+void soft_set_key(const unsigned char *key)
+{
+    unsigned int i;
+    unsigned char j;
+    unsigned char temp[4];
+    unsigned char swap;
+    unsigned char rcon = 0x01;
+
+    for(i = 0; i < KEY_SIZE; i = i + 1)
+    {
+        round_keys[i] = key[i];
+    }
+    for(i = KEY_SIZE; i < ROUND_KEY_SIZE; i = i + 4)
+    {
+        for(j = 0; j < 4; j = j + 1)
+        {
+            temp[j] = round_keys[i - 4 + j];
+        }
+        if((i % KEY_SIZE) == 0)                                 // RotWord, SubWord, Rcon
+        {
+            swap = temp[0];
+            temp[0] = sbox[temp[1]] ^ rcon;
+            temp[1] = sbox[temp[2]];
+            temp[2] = sbox[temp[3]];
+            temp[3] = sbox[swap];
+            rcon = xtime(rcon);
+        }
+        else if((i % KEY_SIZE) == 16)                           // SubWord only (256-bit keys)
+        {
+            for(j = 0; j < 4; j = j + 1)
+            {
+                temp[j] = sbox[temp[j]];
+            }
+        }
+        for(j = 0; j < 4; j = j + 1)
+        {
+            round_keys[i + j] = round_keys[i - KEY_SIZE + j] ^ temp[j];
+        }
+    }
+}
+
+void soft_encrypt_block(const unsigned char *in, unsigned char *out)
+{
+    unsigned char state[BLOCK_SIZE];
+    unsigned char shifted[BLOCK_SIZE];
+    unsigned char round;
+    unsigned char i;
+    unsigned char column;
+    unsigned char all;
+    unsigned char *c;
+
+    for(i = 0; i < BLOCK_SIZE; i = i + 1)                       // AddRoundKey (round 0)
+    {
+        state[i] = in[i] ^ round_keys[i];
+    }
+
+    for(round = 1; round <= 14; round = round + 1)
+    {
+        for(i = 0; i < BLOCK_SIZE; i = i + 1)                   // SubBytes and ShiftRows
+        {                                                       // (row = i % 4, column = i / 4)
+            shifted[i] = sbox[state[(i + 4 * (i % 4)) % BLOCK_SIZE]];
+        }
+
+        for(column = 0; column < 4; column = column + 1)        // MixColumns (not in the last round)
+        {
+            c = &shifted[column * 4];
+            if(round != 14)
+            {
+                all = c[0] ^ c[1] ^ c[2] ^ c[3];
+                state[column * 4 + 0] = c[0] ^ all ^ xtime(c[0] ^ c[1]);
+                state[column * 4 + 1] = c[1] ^ all ^ xtime(c[1] ^ c[2]);
+                state[column * 4 + 2] = c[2] ^ all ^ xtime(c[2] ^ c[3]);
+                state[column * 4 + 3] = c[3] ^ all ^ xtime(c[3] ^ c[0]);
+            }
+            else
+            {
+                state[column * 4 + 0] = c[0];
+                state[column * 4 + 1] = c[1];
+                state[column * 4 + 2] = c[2];
+                state[column * 4 + 3] = c[3];
+            }
+        }
+
+        for(i = 0; i < BLOCK_SIZE; i = i + 1)                   // AddRoundKey
+        {
+            state[i] = state[i] ^ round_keys[round * BLOCK_SIZE + i];
+        }
+    }
+
+    for(i = 0; i < BLOCK_SIZE; i = i + 1)
+    {
+        out[i] = state[i];
+    }
+}
+
+// ***************************************
+// Hardware against the model
+// ***************************************
+unsigned char same(const unsigned char *a, const unsigned char *b, unsigned int length)
+{
+    while(length > 0)
+    {
+        if(*a != *b)
+        {
+            return 0;
+        }
+        a = a + 1;
+        b = b + 1;
+        length = length - 1;
+    }
+    return 1;
+}
+
+unsigned char check_loopback(unsigned int size)
+{
+    const unsigned int tamper[3] = {4, HEADER_SIZE + 5, HEADER_SIZE + FRAME_SIZE + 2}; // Header, cipher text, tag
+    unsigned int length;
+    unsigned char ok;
+    unsigned char i;
+
+    for(i = 0; i < 3; i = i + 1)
+    {
+        frame[tamper[i]] = frame[tamper[i]] ^ 0x01;             // One bit changed on the "wire"
+        ok = verify_secure_frame(frame, size, received, &length);
+        frame[tamper[i]] = frame[tamper[i]] ^ 0x01;             // Put it back for sending
+        if(ok)
+        {
+            return 0;
+        }
+    }
+
+    ok = verify_secure_frame(frame, size, received, &length);
+    if((ok == 0) || (length != FRAME_SIZE) || (same(received, message, FRAME_SIZE) == 0))
+    {
+        return 0;
+    }
+
+    return (verify_secure_frame(frame, size, received, &length) == 0); // The same frame again
+}
+
+void link_state_init(void)
+{
+    if(link_state.valid != LINK_STATE_VALID)                    // Blank Information memory
+    {
+        link_state.next_number = 0;
+        link_state.lowest_accepted = 0;
+        link_state.valid = LINK_STATE_VALID;                    // Last, in case the power goes
+    }
+}
+
+unsigned char check_model(void)
+{
+    unsigned char hardware[BLOCK_SIZE];
+    unsigned char software[BLOCK_SIZE];
+    unsigned char counter[BLOCK_SIZE];
+    unsigned char *counters = (unsigned char *)counter_blocks;
+    unsigned char *stream = (unsigned char *)key_stream;
+    unsigned char i;
+
+    // 1. The model against FIPS-197
+    soft_set_key(fips_key);
+    soft_encrypt_block(fips_plain, software);
+    if(same(software, fips_cipher, BLOCK_SIZE) == 0)
+    {
+        return 0;
+    }
+
+    // 2. One block in hardware against the model
+    aes_load_key(fips_key);
+    aes_encrypt_block(fips_plain, hardware);
+    if(same(hardware, software, BLOCK_SIZE) == 0)
+    {
+        return 0;
+    }
+
+    // 3. DMA key stream against the model
+    for(i = 0; i < DMA_BLOCKS; i = i + 1)
+    {
+        make_counter_block(0x12345678, i, &counters[i * BLOCK_SIZE]);
+    }
+    aes_encrypt_blocks_dma(counters, stream, DMA_BLOCKS);
+    for(i = 0; i < DMA_BLOCKS; i = i + 1)
+    {
+        make_counter_block(0x12345678, i, counter);
+        soft_encrypt_block(counter, software);
+        if(same(&stream[i * BLOCK_SIZE], software, BLOCK_SIZE) == 0)
+        {
+            return 0;
+        }
+    }
+
+    // 4. CMAC in hardware and in the model against NIST SP 800-38B
+    soft_set_key(nist_key);
+    cmac(soft_encrypt_block, nist_message, BLOCK_SIZE, software);
+    aes_load_key(nist_key);
+    cmac(aes_encrypt_block, nist_message, BLOCK_SIZE, hardware);
+    return same(software, nist_tag, BLOCK_SIZE) && same(hardware, nist_tag, BLOCK_SIZE);
+}
+
+// *********************
+// Functions
+// *********************
+void send_byte(unsigned char data)
+{
+    while((UCA0IFG & UCTXIFG) == 0);                // Wait for the TX buffer to be empty
+    UCA0TXBUF = data;
+}
+
+
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
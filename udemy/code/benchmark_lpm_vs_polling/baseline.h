@@ -0,0 +1,41 @@
+/*
+ * baseline.h - the results every new build of the benchmark is compared against
+ *
+ * The baseline is NOT kept in FRAM. A #pragma PERSISTENT variable is part of the image,
+ * so CCS writes it again every time a new build is loaded - the new build would only
+ * ever be compared against itself. The numbers are kept here instead, in a file that is
+ * checked in with the code, and the comparison is between this build and the build the
+ * numbers came from.
+ *
+ * RECORDING A NEW BASELINE
+ * ------------------------
+ *  1. Build and run the benchmark on the build you want to compare against.
+ *  2. Copy the results into the table below, one row per workload. Either
+ *       - read bench_results[] in the debugger (Expressions view), or
+ *       - save the UART frames on the PC - after 0xA5 and the workload number, the
+ *         fields come in the same order as below, LSB first.
+ *  3. Set BASELINE_RECORDED to 1 and check the file in with the code.
+ *
+ * Only change the numbers when a slower (or faster) result is what you want from now on
+ * - the commit then shows what changed, and by how much.
+ *
+ * While BASELINE_RECORDED is 0 there is nothing to compare against: both LEDs are turned
+ * on and the results are only sent out on the UART.
+ *
+ * This file is included ONCE, by main.c, after struct bench_result.
+ */
+
+#ifndef BASELINE_H_
+#define BASELINE_H_
+
+#define BASELINE_RECORDED       0                               // 1 - the table below has real results
+
+//  active_ticks, total_ticks, {WINDOW, OVERFLOW, WORK_TICK, UART}, uart_bytes, peak_stack
+const struct bench_result baseline[NUMBER_OF_WORKLOADS] =
+{
+    { 0, 0, {0, 0, 0, 0}, 0, 0 },                               // POLLED
+    { 0, 0, {0, 0, 0, 0}, 0, 0 },                               // LPM_TICK
+    { 0, 0, {0, 0, 0, 0}, 0, 0 },                               // UART_TX
+};
+
+#endif /* BASELINE_H_ */
@@ -0,0 +1,452 @@
+/*
+ * Regression benchmark for the LPM, push-button and UART examples.
+ *
+ * Three workloads are run one after the other, each for BENCH_SECONDS of (ACLK) time.
+ * They are COPIES of the main() loops and ISRs of three other projects in this folder -
+ * every project has its own main() and its own interrupt vectors, so they can not be
+ * linked into one program. A change to those projects is not seen here until the copy
+ * below is changed too:
+ *
+ *  1. POLLED   - the push_button loop: the CPU spins on P1IN and never sleeps
+ *  2. LPM_TICK - the lpm_challenge_1 program: sleep in LPM0, wake every 2000 ACLK
+ *                ticks (50ms) to look at P1.1
+ *  3. UART_TX  - the uart_challenge_1 count-down, restarted forever from the UART
+ *                TX ComPleTe interrupt while main() sleeps in LPM0
+ *
+ * For every workload we record:
+ *  - active_ticks   SMCLK ticks (8MHz, 125ns) with the CPU awake
+ *  - total_ticks    SMCLK ticks for the whole window
+ *                   (LPM residency is total_ticks - active_ticks)
+ *  - isr_count[]    how many times each interrupt vector ran
+ *  - uart_bytes     bytes written to UCA0TXBUF
+ *  - peak_stack     deepest stack use in bytes (found by "painting" the stack)
+ *
+ * HOW THE CPU-ACTIVE TIME IS MEASURED:
+ * The MSP430 does not have a cycle counter, so Timer1 runs from SMCLK in CONTINUOUS
+ * mode and we read TA1R whenever the CPU wakes up or goes back to sleep. SMCLK keeps
+ * running in LPM0, so TA1R keeps counting while the CPU is off. Timer1 rolls over every
+ * 65536 * 125ns = 8.192ms, and its overflow interrupt is used to keep the 32-bit totals.
+ *
+ * REGRESSION CHECK:
+ * Each workload is compared to the baseline in baseline.h - a table of the results of
+ * an earlier build, checked in with the code (see baseline.h for how to record it):
+ *  - active_ticks, the ISR counts and peak_stack must not GROW by more than
+ *    TOLERANCE_PERCENT (is_regression)
+ *  - uart_bytes and the LPM residency (total_ticks - active_ticks) must not DROP by more
+ *    than TOLERANCE_PERCENT (is_shortfall) - fewer bytes or less sleep is worse too
+ * If any of these fails, the red LED is turned on, otherwise the green LED is turned
+ * on. Both LEDs on means baseline.h has no results yet (BASELINE_RECORDED 0).
+ *
+ * At the end, the results are also sent out on the UART (P4.2, 9600 baud) so a PC can
+ * save them. Each workload is one frame:
+ *
+ *   0xA5, workload number, then every field of struct bench_result (LSB first)
+ *
+ * The results are also left in bench_results[] so they can be read in the debugger.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE                          // Required to use inputs and outputs
+#define ACLK                    0x0100                          // Timer_A ACLK source
+#define SMCLK                   0x0200                          // Timer_A SMCLK source
+#define UP                      0x0010                          // Timer_A UP mode
+#define CONTINUOUS              0x0020                          // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080                          // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                            // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                            // Value required to use 9600 baud
+#define CLK_MOD                 0x4911                          // uC will "clean up" clock signal
+
+#define ONE_SECOND              40000                           // 40000 * 25us = 1 sec
+#define FIFTY_MS                2000                            // 2000 * 25us = 50ms (lpm_challenge_1)
+#define BENCH_SECONDS           10                              // Length of each workload window
+#define TOLERANCE_PERCENT       5                               // Allowed growth before a regression
+#define STACK_PAINT             0xCDCD                          // Pattern written over the unused stack
+#define FRAME_START             0xA5                            // First byte of every UART result frame
+
+// Workloads
+#define POLLED                  0
+#define LPM_TICK                1
+#define UART_TX                 2
+#define NUMBER_OF_WORKLOADS     3
+
+// Index into isr_count[] for each interrupt vector we use
+#define ISR_WINDOW              0                               // TIMER0_A0_VECTOR (1 second window)
+#define ISR_OVERFLOW            1                               // TIMER1_A1_VECTOR (measurement timer)
+#define ISR_WORK_TICK           2                               // TIMER2_A0_VECTOR (lpm_challenge_1 tick)
+#define ISR_UART                3                               // USCI_A0_VECTOR
+#define NUMBER_OF_VECTORS       4
+
+struct bench_result
+{
+    unsigned long active_ticks;                                 // SMCLK ticks with the CPU on
+    unsigned long total_ticks;                                  // SMCLK ticks in the whole window
+    unsigned int  isr_count[NUMBER_OF_VECTORS];                 // Interrupts taken per vector
+    unsigned int  uart_bytes;                                   // Bytes sent by the workload
+    unsigned int  peak_stack;                                   // Deepest stack use in bytes
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                                // Assigns uC clock signals
+void assign_pins_to_uart(void);                                 // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                                       // UART operates at 9600 bits per second
+void run_workload(unsigned char workload);                      // Runs one workload for BENCH_SECONDS
+void paint_stack(void);                                         // Fills unused stack with STACK_PAINT
+unsigned int measure_peak_stack(void);                          // Finds the deepest unpainted word
+unsigned char is_regression(unsigned long now, unsigned long then);   // Grew too much
+unsigned char is_shortfall(unsigned long now, unsigned long then);    // Dropped too much
+void send_byte(unsigned char data);                             // Polled UART transmit
+void send_result(unsigned char workload);                       // Sends one result frame
+
+// Linker generated symbols for the bottom and top of the .stack section
+extern unsigned int _stack;
+extern unsigned int __STACK_END;
+
+#include "baseline.h"                                           // Results of an earlier build
+
+struct bench_result bench_results[NUMBER_OF_WORKLOADS];         // Results of this run
+
+struct bench_result *current;                                   // Result for the running workload
+volatile unsigned char bench_done;                              // Set when the window has ended
+volatile unsigned char cpu_asleep;                              // 1 while main() is in LPM0
+volatile unsigned int awake_since;                              // TA1R when the CPU last woke up
+unsigned int window_start;                                      // TA1R when the window began
+unsigned int overflows;                                         // Timer1 roll-overs in this window
+unsigned char seconds;                                          // Seconds elapsed in this window
+unsigned char countdown;                                        // uart_challenge_1 count-down state
+
+// Small helpers used by every ISR to add up the time the CPU spends awake
+#define ACTIVE_BEGIN()          awake_since = TA1R
+#define ACTIVE_END()            current->active_ticks += (unsigned int)(TA1R - awake_since)
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char workload;
+    unsigned char failed = 0;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stops WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable pins
+
+    P1DIR = BIT0;                                               // P1.0 red LED is an output
+    P9DIR = BIT7;                                               // P9.7 green LED is an output
+    P1OUT = BIT1;                                               // Red LED off, pull-up for P1.1
+    P1REN = BIT1;
+    P9OUT = 0x00;                                               // Green LED off
+
+    select_clock_signals();                                     // Assigns uC clock signals
+    assign_pins_to_uart();                                      // P4.2 is for TXD, P4.3 is for RXD
+    use_9600_baud();                                            // UART operates at 9600 bits per second
+
+    for(workload = 0; workload < NUMBER_OF_WORKLOADS; workload = workload + 1)
+    {
+        run_workload(workload);
+        send_result(workload);
+    }
+
+    if(BASELINE_RECORDED == 0)                                  // Nothing to compare against yet
+    {
+        P1OUT = P1OUT | BIT0;                                   // Both LEDs - fill in baseline.h
+        P9OUT = P9OUT | BIT7;
+        while(1);
+    }
+
+    for(workload = 0; workload < NUMBER_OF_WORKLOADS; workload = workload + 1)
+    {
+        failed = failed | is_regression(bench_results[workload].active_ticks,
+                                        baseline[workload].active_ticks);
+        failed = failed | is_regression(bench_results[workload].isr_count[ISR_WORK_TICK],
+                                        baseline[workload].isr_count[ISR_WORK_TICK]);
+        failed = failed | is_regression(bench_results[workload].isr_count[ISR_UART],
+                                        baseline[workload].isr_count[ISR_UART]);
+        failed = failed | is_regression(bench_results[workload].peak_stack,
+                                        baseline[workload].peak_stack);
+        failed = failed | is_shortfall(bench_results[workload].uart_bytes,
+                                       baseline[workload].uart_bytes);
+        failed = failed | is_shortfall(bench_results[workload].total_ticks -
+                                       bench_results[workload].active_ticks,
+                                       baseline[workload].total_ticks -
+                                       baseline[workload].active_ticks);
+    }
+
+    if(failed)
+    {
+        P1OUT = P1OUT | BIT0;                                   // Red LED - something got slower
+    }
+    else
+    {
+        P9OUT = P9OUT | BIT7;                                   // Green LED - within tolerance
+    }
+
+    while(1);
+}
+
+// *********************
+// Runs one workload
+// *********************
+void run_workload(unsigned char workload)
+{
+    unsigned char i;
+
+    current = &bench_results[workload];
+    current->active_ticks = 0;
+    current->uart_bytes = 0;
+    for(i = 0; i < NUMBER_OF_VECTORS; i = i + 1)
+    {
+        current->isr_count[i] = 0;
+    }
+
+    bench_done = 0;
+    cpu_asleep = 0;
+    seconds = 0;
+    overflows = 0;
+    paint_stack();
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR | TAIE;                 // Free-running 8MHz measurement timer
+
+    TA0CCR0 = ONE_SECOND;                                       // Window is counted in whole seconds
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+
+    window_start = TA1R;
+    ACTIVE_BEGIN();
+    _BIS_SR(GIE);                                               // Window has started
+
+    if(workload == POLLED)                                      // push_button
+    {
+        while(bench_done == 0)
+        {
+            if(BIT1 & P1IN)                                     // If button is NOT pushed
+            {
+                P1OUT = P1OUT & ~BIT0;                          // Red LED off
+            }
+            else
+            {
+                P1OUT = P1OUT | BIT0;                           // Red LED on
+            }
+        }
+    }
+    else
+    {
+        if(workload == LPM_TICK)                                // lpm_challenge_1
+        {
+            TA2CCR0 = FIFTY_MS;
+            TA2CTL = ACLK | UP | TACLR;
+            TA2CCTL0 = CCIE;
+        }
+        else                                                    // uart_challenge_1
+        {
+            countdown = 10;
+            UCA0IFG = UCA0IFG & (~UCTXCPTIFG);
+            UCA0IE = UCTXCPTIE;                                 // Interrupt when TX stop bit complete
+            UCA0TXBUF = countdown;                              // Start the count-down
+            current->uart_bytes = 1;
+        }
+
+        while(bench_done == 0)
+        {
+            __disable_interrupt();                              // No ISR between the stamp and LPM0
+            ACTIVE_END();
+            cpu_asleep = 1;
+            _BIS_SR(LPM0_bits | GIE);                           // Sleep - only the window end wakes us
+            cpu_asleep = 0;
+            ACTIVE_BEGIN();
+        }
+
+        TA2CTL = 0;                                             // Stop the lpm_challenge_1 timer
+        TA2CCTL0 = 0;
+        UCA0IE = 0;                                             // Stop the count-down
+    }
+
+    __disable_interrupt();
+    ACTIVE_END();
+    if(TA1CTL & TAIFG)                                          // Roll-over that the ISR has not seen yet
+    {
+        overflows = overflows + 1;
+    }
+    current->total_ticks = ((unsigned long)overflows << 16) + TA1R - window_start;
+    TA0CTL = 0;                                                 // Stop both timers
+    TA1CTL = 0;
+    current->peak_stack = measure_peak_stack();
+}
+
+// *************************
+// Stack painting
+// *************************
+void paint_stack(void)
+{
+    unsigned int *word = &_stack;
+    unsigned int *in_use = (unsigned int *)__get_SP_register() - 8;   // Leave our own frame alone
+
+    while(word < in_use)
+    {
+        *word = STACK_PAINT;
+        word = word + 1;
+    }
+}
+
+unsigned int measure_peak_stack(void)
+{
+    unsigned int *word = &_stack;
+
+    while((word < &__STACK_END) && (*word == STACK_PAINT))      // Skip words never written
+    {
+        word = word + 1;
+    }
+    return (unsigned int)((char *)&__STACK_END - (char *)word);
+}
+
+// *************************
+// Baseline comparison
+// *************************
+// The ticks go up to 80 million, so * 100 needs 64 bits
+unsigned char is_regression(unsigned long now, unsigned long then)
+{
+    return (unsigned long long)now * 100 > (unsigned long long)then * (100 + TOLERANCE_PERCENT);
+}
+
+unsigned char is_shortfall(unsigned long now, unsigned long then)
+{
+    return (unsigned long long)now * 100 < (unsigned long long)then * (100 - TOLERANCE_PERCENT);
+}
+
+// *************************
+// UART result frames
+// *************************
+void send_byte(unsigned char data)
+{
+    while((UCA0IFG & UCTXIFG) == 0);                            // Wait for the TX buffer to be empty
+    UCA0TXBUF = data;
+}
+
+void send_result(unsigned char workload)
+{
+    unsigned char *data = (unsigned char *)&bench_results[workload];
+    unsigned char i;
+
+    send_byte(FRAME_START);
+    send_byte(workload);
+    for(i = 0; i < sizeof(struct bench_result); i = i + 1)      // MSP430 is little-endian
+    {
+        send_byte(data[i]);
+    }
+}
+
+// ******************************************
+// Timer0 ISR - one second of the window
+// ******************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    if(cpu_asleep) ACTIVE_BEGIN();
+    current->isr_count[ISR_WINDOW] = current->isr_count[ISR_WINDOW] + 1;
+
+    seconds = seconds + 1;
+    if(seconds == BENCH_SECONDS)
+    {
+        bench_done = 1;
+        __bic_SR_register_on_exit(LPM0_bits);                   // Wake main() to end the workload
+    }
+    if(cpu_asleep) ACTIVE_END();
+}
+
+// ******************************************
+// Timer1 ISR - measurement timer roll-over
+// ******************************************
+#pragma vector=TIMER1_A1_VECTOR
+__interrupt void Timer1_Overflow_ISR(void)
+{
+    if(cpu_asleep) ACTIVE_BEGIN();
+    if(TA1IV == TA1IV_TAIFG)                                    // Reading TA1IV clears TAIFG
+    {
+        current->isr_count[ISR_OVERFLOW] = current->isr_count[ISR_OVERFLOW] + 1;
+        overflows = overflows + 1;
+        if(cpu_asleep == 0)                                     // POLLED never sleeps, so bank the
+        {                                                       // awake time before TA1R wraps again
+            ACTIVE_END();
+            ACTIVE_BEGIN();
+        }
+    }
+    if(cpu_asleep) ACTIVE_END();
+}
+
+// ******************************************
+// Timer2 ISR - lpm_challenge_1 workload
+// ******************************************
+#pragma vector=TIMER2_A0_VECTOR
+__interrupt void Timer2_ISR(void)
+{
+    if(cpu_asleep) ACTIVE_BEGIN();
+    current->isr_count[ISR_WORK_TICK] = current->isr_count[ISR_WORK_TICK] + 1;
+
+    if(BIT1 & P1IN)                                             // If button is NOT pushed
+    {
+        P1OUT = P1OUT & ~BIT0;                                  // Red LED off
+    }
+    else
+    {
+        P1OUT = P1OUT | BIT0;                                   // Red LED on
+    }
+    if(cpu_asleep) ACTIVE_END();
+}
+
+// ******************************************
+// UART ISR - uart_challenge_1 workload
+// ******************************************
+#pragma vector=USCI_A0_VECTOR
+__interrupt void UART_ISR(void)
+{
+    if(cpu_asleep) ACTIVE_BEGIN();
+    current->isr_count[ISR_UART] = current->isr_count[ISR_UART] + 1;
+
+    UCA0IFG = UCA0IFG & (~UCTXCPTIFG);                          // Clear TX ComPleTe flag before the next byte
+    if(countdown == 0)                                          // Restart the count-down
+    {
+        countdown = 10;
+    }
+    else
+    {
+        countdown = countdown - 1;
+    }
+    UCA0TXBUF = countdown;
+    current->uart_bytes = current->uart_bytes + 1;
+    if(cpu_asleep) ACTIVE_END();
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
@@ -0,0 +1,223 @@
+/*
+ * Waking up only when a voltage crosses a threshold, with Comparator_E
+ *
+ * lpm_challenge_1 wakes up every 2000 ACLK counts (50ms) just to look at P1IN, and
+ * checking an analog voltage the same way would need an ADC conversion every time. That
+ * is 72000 wake-ups an hour even if nothing ever changes.
+ *
+ * Comparator_E compares two voltages all by itself, even in LPM3 and LPM4, and
+ * interrupts when the answer (CEOUT) changes:
+ *
+ *      + terminal   the voltage we are watching, on P1.3 (input C3)
+ *      - terminal   a threshold from the resistor "ladder" - VCC cut into 32 steps,
+ *                   threshold = VCC * (tap + 1) / 32
+ *
+ * HYSTERESIS
+ * ----------
+ * A noisy voltage sitting right at the threshold would make the comparator switch back
+ * and forth. So there are two thresholds: the ladder gives VREF0 (tap CEREF0) and VREF1
+ * (tap CEREF1). While the input is below, the comparator uses the HIGH one; once it has
+ * gone above, it switches to the LOW one. The ISR does the switch (CEMRVS = 1, CEMRVL)
+ * and also flips CEIES so the next interrupt is for the other direction.
+ *
+ * CALIBRATION
+ * -----------
+ * Using VCC for the ladder costs no extra current, but the thresholds move when VCC
+ * does. cmp_calibrate() measures VCC once with the ADC (AVCC / 2 against the internal
+ * 2.5V reference) and keeps it in vcc_mv, then cmp_set_threshold_mv() works out the taps
+ * for the thresholds in millivolts. It must come before cmp_init(), which compares the
+ * input with the HIGH threshold to decide where to start. Call it again if the supply
+ * (a battery) changes.
+ *
+ * WAKE-UPS
+ * --------
+ * The red LED shows if the voltage is above the threshold. Timer0 counts ACLK / 64 so it
+ * only rolls over every 104.9 seconds (that is the only other wake-up). crossings,
+ * seconds and wakeups_per_hour are worked out every time we wake, next to
+ * POLLED_WAKEUPS_PER_HOUR for lpm_challenge_1's way.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define TICKS_PER_SECOND        625                 // 40000 / 64
+#define POLLED_WAKEUPS_PER_HOUR 72000               // One every 50ms (lpm_challenge_1)
+
+#define INPUT_CHANNEL           3                   // C3 is P1.3
+#define HIGH_THRESHOLD_MV       1800                // Goes "above" here...
+#define LOW_THRESHOLD_MV        1500                // ...and "below" again here
+#define LADDER_STEPS            32
+
+// ********************
+// Function Definitions
+// ********************
+void cmp_init(unsigned char channel);               // Input on the + terminal, ladder on -
+void cmp_calibrate(void);                           // Measures VCC into vcc_mv
+void cmp_set_threshold_mv(unsigned int high_mv, unsigned int low_mv); // Before cmp_init()
+unsigned char ladder_tap(unsigned int mv);
+
+unsigned int vcc_mv;                                // From cmp_calibrate()
+unsigned char high_tap;                             // CEREF0
+unsigned char low_tap;                              // CEREF1
+
+volatile unsigned long crossings;                   // Comparator wake-ups
+volatile unsigned int overflows;                    // Timer0 wake-ups
+unsigned long seconds;
+unsigned long wakeups_per_hour;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P1OUT = 0x00;
+
+    cmp_calibrate();
+    cmp_set_threshold_mv(HIGH_THRESHOLD_MV, LOW_THRESHOLD_MV); // Taps first - cmp_init() reads CEOUT
+    cmp_init(INPUT_CHANNEL);
+
+    TA0CTL = ACLK | ID_3 | CONTINUOUS | TACLR | TAIE; // ACLK / 8...
+    TA0EX0 = TAIDEX_7;                              // ...and / 8 again
+
+    while(1)
+    {
+        _BIS_SR(LPM3_bits | GIE);                   // Nothing runs until a crossing
+
+        seconds = ((unsigned long)overflows * 65536 + TA0R) / TICKS_PER_SECOND;
+        if(seconds > 0)
+        {
+            wakeups_per_hour = ((crossings + overflows) * 3600) / seconds;
+        }
+    }
+}
+
+// ******************************
+// Comparator_E driver
+// ******************************
+void cmp_init(unsigned char channel)
+{
+    CECTL0 = CEIPEN | channel;                      // Input channel on the + terminal
+    CECTL1 = CEPWRMD_2 | CEF | CEFDLY_3 | CEMRVS;   // Ultra-low power, filtered, we pick VREF0/1
+    CECTL2 = (CECTL2 & (CEREF0_31 | CEREF1_31)) | CERS_1 | CERSEL; // Keep the taps, VCC to the ladder on -
+    CECTL3 = 1 << channel;                          // Turn off the pin's digital input
+
+    CECTL1 = CECTL1 | CEON;
+    __delay_cycles(400);                            // Let the comparator settle
+
+    CEINT = CEINT & ~(CEIFG | CEIIFG);
+    if(CECTL1 & CEOUT)                              // Start on the right threshold
+    {
+        CECTL1 = CECTL1 | CEMRVL | CEIES;           // Above - VREF1, wait for it to fall
+        P1OUT = P1OUT | BIT0;
+    }
+    else
+    {
+        CECTL1 = CECTL1 & ~(CEMRVL | CEIES);        // Below - VREF0, wait for it to rise
+    }
+    CEINT = (CEINT & ~CEIFG) | CEIE;
+}
+
+void cmp_calibrate(void)
+{
+    unsigned int result;
+
+    REFCTL0 = REFVSEL_2 | REFON;                    // 2.5V reference
+    ADC12CTL0 = ADC12SHT0_8 | ADC12ON;              // Long sample time for the internal channel
+    ADC12CTL1 = ADC12SHP;
+    ADC12CTL2 = ADC12RES_2;                         // 12 bits
+    ADC12CTL3 = ADC12BATMAP;                        // Channel 31 is AVCC / 2
+    ADC12MCTL0 = ADC12INCH_31 | ADC12VRSEL_1;       // Measured against the 2.5V reference
+    while(!(REFCTL0 & REFGENRDY));
+
+    ADC12CTL0 = ADC12CTL0 | ADC12ENC | ADC12SC;
+    while(!(ADC12IFGR0 & ADC12IFG0));
+    result = ADC12MEM0;
+
+    ADC12CTL0 = ADC12CTL0 & ~ADC12ENC;              // Everything off again
+    ADC12CTL0 = 0;
+    REFCTL0 = 0;
+
+    vcc_mv = ((unsigned long)result * 2 * 2500) / 4096;
+}
+
+unsigned char ladder_tap(unsigned int mv)
+{
+    unsigned int tap;
+
+    tap = (((unsigned long)mv * LADDER_STEPS) + (vcc_mv / 2)) / vcc_mv; // Nearest step
+    if(tap == 0)
+    {
+        tap = 1;
+    }
+    if(tap > LADDER_STEPS)
+    {
+        tap = LADDER_STEPS;
+    }
+    return tap - 1;                                 // threshold = VCC * (tap + 1) / 32
+}
+
+void cmp_set_threshold_mv(unsigned int high_mv, unsigned int low_mv)
+{
+    high_tap = ladder_tap(high_mv);
+    low_tap = ladder_tap(low_mv);
+    if(high_tap == 0)                               // Room for a LOW step under it
+    {
+        high_tap = 1;
+    }
+    if(low_tap >= high_tap)                         // Keep at least one step of hysteresis
+    {
+        low_tap = high_tap - 1;
+    }
+    CECTL2 = (CECTL2 & ~(CEREF0_31 | CEREF1_31)) | high_tap | (low_tap << 8);
+}
+
+// ******************************
+// Comparator_E ISR
+// ******************************
+#pragma vector=COMP_E_VECTOR
+__interrupt void Comparator_ISR(void)
+{
+    switch(__even_in_range(CEIV, CEIV_CERDYIFG))
+    {
+        case CEIV_CEIFG:
+        {
+            crossings = crossings + 1;
+            if(CECTL1 & CEIES)                      // It fell below the LOW threshold
+            {
+                CECTL1 = CECTL1 & ~(CEMRVL | CEIES); // Use the HIGH one, wait for a rise
+                P1OUT = P1OUT & ~BIT0;
+            }
+            else                                    // It rose above the HIGH threshold
+            {
+                CECTL1 = CECTL1 | CEMRVL | CEIES;   // Use the LOW one, wait for a fall
+                P1OUT = P1OUT | BIT0;
+            }
+            CEINT = CEINT & ~CEIFG;                 // Changing CEIES can set it again
+            __bic_SR_register_on_exit(LPM3_bits);   // Wake up main() to count it
+            break;
+        }
+    }
+}
+
+// ******************************
+// Timer0 ISR - roll-over
+// ******************************
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    switch(__even_in_range(TA0IV, TA0IV_TAIFG))
+    {
+        case TA0IV_TAIFG:
+        {
+            overflows = overflows + 1;
+            __bic_SR_register_on_exit(LPM3_bits);
+            break;
+        }
+    }
+}
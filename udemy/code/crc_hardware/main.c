@@ -0,0 +1,371 @@
+/*
+ * Checking data with the CRC16 hardware module
+ *
+ * A CRC (Cyclic Redundancy Check) is a 16 or 32-bit number worked out from a block of
+ * data. The sender sends the CRC after the data, the receiver works it out again, and if
+ * the two numbers are different, the data was damaged. Working a CRC out in software
+ * takes many instructions per byte, but the MSP430FR6989 has a CRC16 module that does
+ * it in hardware: write the data into a register and read the answer back.
+ *
+ *  CRCINIRES   Write the starting value (the "seed") here. Read the answer from here.
+ *  CRCDIRB     Write data here. "RB" means Reversed Bits - written this way, the answer
+ *              in CRCINIRES is the standard CRC-16-CCITT (0x1021 polynomial, 0xFFFF seed)
+ *              that a PC would work out. Byte writes go to CRCDIRB_L, word writes to
+ *              CRCDIRB (low byte first, so a word write is the same as two byte writes).
+ *
+ * The FR6989 does not have the 32-bit CRC module, so crc32_software() uses a small
+ * table instead (the Ethernet/zip CRC-32).
+ *
+ * INTERLEAVED STREAMS
+ * -------------------
+ * There is only one CRC module, but a program may be checking a UART frame and an FRAM
+ * record at the same time. Each stream keeps its own struct crc16_stream. crc16_add()
+ * writes the stream's saved value back into CRCINIRES first (so the module carries on
+ * where that stream stopped), adds the new data, then saves CRCINIRES again. Do not use
+ * the module from an ISR while main() is in crc16_add(). The self test takes turns
+ * between a frame (buffer[], 16 bytes at a time) and a record ("123456789" each time)
+ * and checks both answers against crc16_reference() (streams_match).
+ *
+ * BULK (DMA) MODE
+ * ---------------
+ * For big buffers, DMA channel 0 copies the data one word at a time into CRCDIRB. The
+ * CPU only sets it up and starts it - the DMA does the rest.
+ *
+ * REFERENCE AND BENCHMARK
+ * -----------------------
+ * crc16_reference() works the CRC out one bit at a time, exactly as the standard
+ * describes it. It is slow, but easy to check by hand and matches any PC CRC-16-CCITT
+ * tool, so all the fast versions are compared against it (crc_matches[] is 1 if they
+ * agree). Each mode is also timed with Timer1 running from SMCLK = MCLK = 8MHz, and the
+ * cycles per byte are kept in cycles_per_byte[] for the debugger.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define CRC16_SEED              0xFFFF              // CRC-16-CCITT starting value
+#define CRC16_POLYNOMIAL        0x1021
+#define CRC32_SEED              0xFFFFFFFF          // CRC-32 starting value
+#define BUFFER_SIZE             128                 // Bytes used by the benchmark (must be even)
+#define FRAME_CHUNK             16                  // Bytes of buffer[] added to frame each turn
+#define RECORDS                 (BUFFER_SIZE / FRAME_CHUNK) // "123456789"s added to record
+
+// Benchmark modes
+#define SOFTWARE_TABLE          0                   // 256 entry table, one byte per step
+#define HARDWARE_BYTE           1                   // CRCDIRB_L, one byte per write
+#define HARDWARE_WORD           2                   // CRCDIRB, two bytes per write
+#define HARDWARE_DMA            3                   // DMA writes CRCDIRB
+#define NUMBER_OF_MODES         4
+
+struct crc16_stream
+{
+    unsigned int state;                             // CRCINIRES saved between calls
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                                // Assigns uC clock signals
+unsigned int crc16_reference(const unsigned char *data, unsigned int length);
+unsigned int crc16_software(const unsigned char *data, unsigned int length);
+void crc16_start(struct crc16_stream *stream);
+void crc16_add(struct crc16_stream *stream, const unsigned char *data, unsigned int length);
+unsigned int crc16_result(struct crc16_stream *stream);
+unsigned int crc16_bytes(const unsigned char *data, unsigned int length);
+unsigned int crc16_dma(const unsigned int *data, unsigned int words);
+unsigned long crc32_software(const unsigned char *data, unsigned int length);
+unsigned int time_mode(unsigned char mode);                     // Cycles for one CRC of buffer[]
+
+// CRC-32 (reflected 0xEDB88320), 4 bits at a time
+const unsigned long crc32_table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// CRC-16-CCITT (0x1021) of each byte value on its own, starting from 0. Worked out on a
+// PC, so it is const and stays in FRAM instead of taking 512 bytes of the 2KB RAM
+const unsigned int crc16_table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+unsigned int buffer[BUFFER_SIZE / 2];                           // Word aligned so DMA and word writes work
+unsigned int crc_answer[NUMBER_OF_MODES];                       // Answer from each mode
+unsigned char crc_matches[NUMBER_OF_MODES];                     // 1 if the mode agrees with the reference
+unsigned int cycles_per_byte[NUMBER_OF_MODES];
+unsigned int reference_answer;
+unsigned char streams_match;                                    // 1 if both interleaved streams gave the right answer
+unsigned long crc32_answer;
+unsigned char crc32_check_ok;                                   // 1 if CRC-32 of "123456789" is 0xCBF43926
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char *bytes = (unsigned char *)buffer;
+    unsigned char mode;
+    unsigned int i;
+    unsigned int record_answer;
+    unsigned char all_records[RECORDS * 9];                     // What record saw, in one piece
+    struct crc16_stream frame;                                  // e.g. a UART frame
+    struct crc16_stream record;                                 // e.g. an FRAM record
+    const unsigned char check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable inputs and outputs
+
+    P1DIR = BIT0;                                               // Red LED - something did not match
+    P9DIR = BIT7;                                               // Green LED - everything matched
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                                     // MCLK = SMCLK = 8MHz
+
+    for(i = 0; i < BUFFER_SIZE; i = i + 1)                      // Something to check
+    {
+        bytes[i] = (unsigned char)(i * 7 + 3);
+    }
+    reference_answer = crc16_reference(bytes, BUFFER_SIZE);
+
+    for(mode = 0; mode < NUMBER_OF_MODES; mode = mode + 1)
+    {
+        cycles_per_byte[mode] = time_mode(mode) / BUFFER_SIZE;
+        crc_matches[mode] = (crc_answer[mode] == reference_answer);
+    }
+
+    // Two streams taking turns on the one CRC module
+    crc16_start(&frame);
+    crc16_start(&record);
+    for(i = 0; i < BUFFER_SIZE; i = i + FRAME_CHUNK)
+    {
+        crc16_add(&frame, &bytes[i], FRAME_CHUNK);
+        crc16_add(&record, &check[0], 9);
+    }
+    for(i = 0; i < RECORDS * 9; i = i + 1)
+    {
+        all_records[i] = check[i % 9];
+    }
+    record_answer = crc16_reference(all_records, RECORDS * 9);
+    streams_match = (crc16_result(&frame) == reference_answer) && (crc16_result(&record) == record_answer);
+
+    crc32_answer = crc32_software(check, 9);
+    crc32_check_ok = (crc32_answer == 0xCBF43926);
+
+    if(streams_match && crc32_check_ok && crc_matches[SOFTWARE_TABLE] && crc_matches[HARDWARE_BYTE] &&
+       crc_matches[HARDWARE_WORD] && crc_matches[HARDWARE_DMA])
+    {
+        P9OUT = BIT7;
+    }
+    else
+    {
+        P1OUT = BIT0;
+    }
+
+    while(1);
+}
+
+// *******************************
+// Bit at a time reference
+// *******************************
+unsigned int crc16_reference(const unsigned char *data, unsigned int length)
+{
+    unsigned int crc = CRC16_SEED;
+    unsigned char bit;
+
+    while(length > 0)
+    {
+        crc = crc ^ ((unsigned int)*data << 8);                 // Next byte goes in at the top
+        for(bit = 0; bit < 8; bit = bit + 1)
+        {
+            if(crc & 0x8000)
+            {
+                crc = (crc << 1) ^ CRC16_POLYNOMIAL;
+            }
+            else
+            {
+                crc = crc << 1;
+            }
+        }
+        data = data + 1;
+        length = length - 1;
+    }
+    return crc;
+}
+
+// *******************************
+// Software table version
+// *******************************
+unsigned int crc16_software(const unsigned char *data, unsigned int length)
+{
+    unsigned int crc = CRC16_SEED;
+
+    while(length > 0)
+    {
+        crc = (crc << 8) ^ crc16_table[(crc >> 8) ^ *data];
+        data = data + 1;
+        length = length - 1;
+    }
+    return crc;
+}
+
+// *******************************
+// Hardware streams
+// *******************************
+void crc16_start(struct crc16_stream *stream)
+{
+    stream->state = CRC16_SEED;
+}
+
+void crc16_add(struct crc16_stream *stream, const unsigned char *data, unsigned int length)
+{
+    CRCINIRES = stream->state;                                  // Carry on from where this stream stopped
+
+    if(((unsigned int)data & 1) && (length > 0))                // Odd address - one byte to line up
+    {
+        CRCDIRB_L = *data;
+        data = data + 1;
+        length = length - 1;
+    }
+    while(length > 1)                                           // Two bytes per write
+    {
+        CRCDIRB = *(const unsigned int *)data;
+        data = data + 2;
+        length = length - 2;
+    }
+    if(length > 0)                                              // Last odd byte
+    {
+        CRCDIRB_L = *data;
+    }
+
+    stream->state = CRCINIRES;                                  // Save for next time
+}
+
+unsigned int crc16_result(struct crc16_stream *stream)
+{
+    return stream->state;
+}
+
+unsigned int crc16_bytes(const unsigned char *data, unsigned int length)
+{
+    CRCINIRES = CRC16_SEED;
+    while(length > 0)
+    {
+        CRCDIRB_L = *data;
+        data = data + 1;
+        length = length - 1;
+    }
+    return CRCINIRES;
+}
+
+unsigned int crc16_dma(const unsigned int *data, unsigned int words)
+{
+    CRCINIRES = CRC16_SEED;
+
+    DMACTL0 = DMA0TSEL_0;                                       // Channel 0 is started by software (DMAREQ)
+    __data20_write_long((unsigned long)&DMA0SA, (unsigned long)data);    // From the buffer...
+    __data20_write_long((unsigned long)&DMA0DA, (unsigned long)&CRCDIRB);    // ...to the CRC module
+    DMA0SZ = words;
+    DMA0CTL = DMADT_1 | DMASRCINCR_3 | DMADSTINCR_0 | DMAEN;    // Block, source address goes up, word size
+    DMA0CTL = DMA0CTL | DMAREQ;                                 // Go - the CPU waits until the block is done
+
+    return CRCINIRES;
+}
+
+// *******************************
+// CRC-32 in software
+// *******************************
+unsigned long crc32_software(const unsigned char *data, unsigned int length)
+{
+    unsigned long crc = CRC32_SEED;
+
+    while(length > 0)
+    {
+        crc = (crc >> 4) ^ crc32_table[(crc ^ *data) & 0x0F];
+        crc = (crc >> 4) ^ crc32_table[(crc ^ (*data >> 4)) & 0x0F];
+        data = data + 1;
+        length = length - 1;
+    }
+    return ~crc;
+}
+
+// *******************************
+// Benchmark
+// *******************************
+unsigned int time_mode(unsigned char mode)
+{
+    struct crc16_stream stream;
+    unsigned int start;
+    unsigned int end;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;                        // 1 count = 1 MCLK cycle
+
+    start = TA1R;
+    if(mode == SOFTWARE_TABLE)
+    {
+        crc_answer[mode] = crc16_software((unsigned char *)buffer, BUFFER_SIZE);
+    }
+    else if(mode == HARDWARE_BYTE)
+    {
+        crc_answer[mode] = crc16_bytes((unsigned char *)buffer, BUFFER_SIZE);
+    }
+    else if(mode == HARDWARE_WORD)
+    {
+        crc16_start(&stream);
+        crc16_add(&stream, (unsigned char *)buffer, BUFFER_SIZE);
+        crc_answer[mode] = crc16_result(&stream);
+    }
+    else
+    {
+        crc_answer[mode] = crc16_dma(buffer, BUFFER_SIZE / 2);
+    }
+    end = TA1R;
+
+    TA1CTL = 0;
+    return end - start;
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
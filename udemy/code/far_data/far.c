@@ -0,0 +1,38 @@
+/*
+ * far.c - block copies out of FRAM2 and the MPU switch for far.h
+ */
+
+#include <msp430.h>
+#include "far.h"
+
+static unsigned int far_mpu_sam;
+
+void far_copy(int *to, unsigned long from, unsigned int count)
+{
+    while(count != 0)
+    {
+        *to = far_read_int(from);                   // Only this line reaches above 64KB
+        to = to + 1;
+        from = from + 2;
+        count = count - 1;
+    }
+}
+
+void far_unprotect(void)
+{
+    if(MPUCTL0 & MPUENA)
+    {
+        MPUCTL0 = MPUPW | (MPUCTL0 & 0x00FF);       // Unlock
+        far_mpu_sam = MPUSAM;
+        MPUSAM = MPUSAM | MPUSEG3WE;
+    }
+}
+
+void far_protect(void)
+{
+    if(MPUCTL0 & MPUENA)
+    {
+        MPUSAM = far_mpu_sam;
+        MPUCTL0_H = 0x00;                           // Lock again
+    }
+}
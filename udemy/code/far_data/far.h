@@ -0,0 +1,86 @@
+/*
+ * far.h - tables and logs above 64KB (FRAM2), paid for only where they are used
+ *
+ * The MSP430FR6989 has 48KB of FRAM below 64KB and 80KB more above it (FRAM2, 0x10000 -
+ * 0x23FFF). An address above 0xFFFF needs 20 bits, and the compiler's DATA MODEL
+ * decides how big every pointer is:
+ *
+ *      small       16-bit pointers. Data only in the lower 64KB. MOV, ADD, PUSH...
+ *      restricted  20-bit pointers - what all our projects use. Any pointer can reach
+ *                  FRAM2, but every pointer lives in a 20-bit register: MOVX.A, PUSHM.A,
+ *                  4 bytes in RAM for each one - even pointers that never leave RAM.
+ *                  (Each object must be under 64KB, so array indexes stay 16 bits.)
+ *      large       The same, and objects can be bigger than 64KB.
+ *
+ * (Project Properties -> Build -> MSP430 Compiler -> Processor Options -> Data model)
+ *
+ * restricted and large both define __LARGE_DATA_MODEL__ - lnk_msp430fr6989.cmd uses it
+ * to put the code in FRAM2, and the .map file of any of our projects shows .text at
+ * 0x10000. So today the whole program pays for 20-bit pointers.
+ *
+ * TWO BUILD PROFILES
+ * ------------------
+ *  - NEAR (--data_model=small): all the normal code gets 16-bit pointers. FRAM2 is only
+ *    reached through far_read_int() and friends, which become the compiler's 20-bit
+ *    intrinsics (__data20_read_short...). Only those lines use extended instructions.
+ *  - FAR (--data_model=restricted or large): the same far_read_int() lines become plain
+ *    pointer reads, as everything else already uses 20-bit pointers.
+ *
+ * The code is the same for both - only the data model changes. The far_data project has
+ * a build configuration for each: Small (NEAR), Restricted and Large (FAR).
+ *
+ * WHERE THINGS GO
+ * ---------------
+ * This project's lnk_msp430fr6989.cmd splits FRAM2 in three:
+ *
+ *      FRAM2       0x10000 - 0x17FFF   code (restricted and large only)
+ *      FAR_CONST   0x18000 - 0x1BFFF   section .far_const - tables (FAR_CONST_START)
+ *      FAR_LOG     0x1C000 - 0x23FFF   nothing - for logs written while running
+ *
+ * A far table:
+ *
+ *      #pragma DATA_SECTION(table, ".far_const")
+ *      #pragma RETAIN(table)                       // Kept even if the name is never used
+ *      const int table[SIZE] = {...};
+ *
+ *      x = far_read_int(FAR_CONST_START + 2 * i);  // table[i], in any data model
+ *
+ * In the small model C can not take the address of table (it does not fit in 16 bits),
+ * so the address is FAR_CONST_START, which must match the .cmd file. Give each extra
+ * table its own section and address the same way.
+ *
+ * FRAM2 is in MPU segment 3 (read and execute only) when CCS turns the MPU on, so
+ * writes must be between far_unprotect() and far_protect().
+ */
+
+#ifndef FAR_H_
+#define FAR_H_
+
+#include <msp430.h>
+
+#define FAR_CONST_START         0x18000UL           // Must match FAR_CONST in the .cmd file
+#define FAR_CONST_END           0x1C000UL
+#define FAR_LOG_START           0x1C000UL           // Must match FAR_LOG in the .cmd file
+#define FAR_LOG_END             0x24000UL
+
+#ifdef __LARGE_DATA_MODEL__
+
+#define FAR_POINTERS            1                   // restricted or large - plain pointers
+#define far_read_int(address)           (*(const int *)(address))
+#define far_read_char(address)          (*(const unsigned char *)(address))
+#define far_write_int(address, value)   (*(int *)(address) = (value))
+
+#else
+
+#define FAR_POINTERS            0                   // small - 20-bit intrinsics
+#define far_read_int(address)           ((int)__data20_read_short(address))
+#define far_read_char(address)          __data20_read_char(address)
+#define far_write_int(address, value)   __data20_write_short((address), (value))
+
+#endif /* __LARGE_DATA_MODEL__ */
+
+void far_copy(int *to, unsigned long from, unsigned int count); // count ints from FRAM2 to RAM
+void far_unprotect(void);                           // FRAM2 writable (MPU segment 3)
+void far_protect(void);                             // And back
+
+#endif /* FAR_H_ */
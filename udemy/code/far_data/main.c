@@ -0,0 +1,279 @@
+/*
+ * Near and far data - what 20-bit addresses cost, with far.h
+ *
+ * The same 256 entry sine table (Q15, one whole wave) is kept twice:
+ *
+ *      near_table  .const      - lower FRAM, below 64KB
+ *      far_table   .far_const  - FRAM2 at FAR_CONST_START (see far.h and the .cmd file)
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ *  - table_errors - far_table read back through far.h must be the same as near_table,
+ *    the sums below must all agree, and the FAR_LOG_COUNT ints written to FAR_LOG_START
+ *    must read back. With 20-bit pointers (FAR_POINTERS 1) the address the linker gave
+ *    far_table must also be FAR_CONST_START.
+ *
+ *  - Timer1 (1 count = 1 cycle at 8MHz) times each of these over the TABLE_SIZE ints:
+ *      near_read_cycles    add up near_table through a pointer
+ *      far_read_cycles     add up far_table, one far_read_int() each
+ *      far_block_cycles    copy far_table to RAM BLOCK ints at a time (far_copy), then
+ *                          add those up through a pointer
+ *      near_copy_cycles    copy near_table to RAM through two pointers (no far data at
+ *                          all - this is the price the REST of a program pays)
+ *      far_write_cycles    write TABLE_SIZE ints to FAR_LOG_START
+ *
+ * The project has one build configuration for each data model - Small, Restricted and
+ * Large (Project -> Build Configurations -> Set Active, or the arrow next to the hammer).
+ * All three use this folder's lnk_msp430fr6989.cmd and build into their own folder.
+ * Run each and compare the numbers: Restricted against Large shows what objects over
+ * 64KB would add, and Small against either shows what the 20-bit pointers cost the
+ * whole program (pointer_bytes shows which one is running: 2 or 4). The .map file in
+ * each folder shows the code size too.
+ *
+ * Green LED - passed.
+ */
+
+#include <msp430.h>
+#include "far.h"
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define TABLE_SIZE              256
+#define BLOCK                   32                  // ints copied out of FRAM2 at a time
+#define FAR_LOG_COUNT           TABLE_SIZE
+
+#define SINE_VALUES \
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602, \
+      6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793, \
+     12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530, \
+     18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594, \
+     23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790, \
+     27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956, \
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971, \
+     32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757, \
+     32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285, \
+     32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571, \
+     30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683, \
+     27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731, \
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868, \
+     18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279, \
+     12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179, \
+      6393,   5602,   4808,   4011,   3212,   2410,   1608,    804, \
+         0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602, \
+     -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793, \
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, \
+    -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594, \
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, \
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, \
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, \
+    -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757, \
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, \
+    -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571, \
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, \
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, \
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, \
+    -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279, \
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179, \
+     -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804
+
+const int near_table[TABLE_SIZE] = {SINE_VALUES};
+
+#pragma DATA_SECTION(far_table, ".far_const")
+#pragma RETAIN(far_table)                           // Never used by name in the small model
+const int far_table[TABLE_SIZE] = {SINE_VALUES};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+long sum_near(const int *table, unsigned int count);
+long sum_far(unsigned long from, unsigned int count);
+long sum_far_blocks(unsigned long from, unsigned int count);
+void copy_near(int *to, const int *from, unsigned int count);
+void write_far_log(unsigned long to, unsigned int count);
+void run_self_test(void);
+void run_benchmark(void);
+
+int copy[TABLE_SIZE];                               // RAM
+unsigned char pointer_bytes;                        // 2 - small, 4 - restricted or large
+unsigned char table_errors;
+long near_sum;
+long far_sum;
+long far_block_sum;
+unsigned int near_read_cycles;
+unsigned int far_read_cycles;
+unsigned int far_block_cycles;
+unsigned int near_copy_cycles;
+unsigned int far_write_cycles;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    pointer_bytes = sizeof(int *);
+
+    run_benchmark();
+    run_self_test();
+
+    if(table_errors == 0)
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+    else
+    {
+        P1OUT = BIT0;                               // Red LED - look at table_errors
+    }
+
+    _BIS_SR(LPM4_bits);                             // Nothing more to do
+}
+
+// ****************************************************
+// Self test - far data reads back the same as near
+// ****************************************************
+void run_self_test(void)
+{
+    unsigned int i;
+
+#if FAR_POINTERS
+    if((unsigned long)far_table != FAR_CONST_START) // .cmd file and far.h disagree
+    {
+        table_errors = table_errors + 1;
+    }
+#endif
+
+    for(i = 0; i < TABLE_SIZE; i = i + 1)
+    {
+        if(far_read_int(FAR_CONST_START + 2 * (unsigned long)i) != near_table[i])
+        {
+            table_errors = table_errors + 1;
+        }
+        if(far_read_int(FAR_LOG_START + 2 * (unsigned long)i) != (int)(i ^ 0x5A5A))
+        {
+            table_errors = table_errors + 1;
+        }
+    }
+
+    if((far_sum != near_sum) || (far_block_sum != near_sum))
+    {
+        table_errors = table_errors + 1;
+    }
+}
+
+// ****************************************************
+// Benchmark - the same work on near and far data
+// ****************************************************
+void run_benchmark(void)
+{
+    unsigned int start;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    start = TA1R;
+    near_sum = sum_near(near_table, TABLE_SIZE);
+    near_read_cycles = TA1R - start;
+
+    start = TA1R;
+    far_sum = sum_far(FAR_CONST_START, TABLE_SIZE);
+    far_read_cycles = TA1R - start;
+
+    start = TA1R;
+    far_block_sum = sum_far_blocks(FAR_CONST_START, TABLE_SIZE);
+    far_block_cycles = TA1R - start;
+
+    start = TA1R;
+    copy_near(copy, near_table, TABLE_SIZE);
+    near_copy_cycles = TA1R - start;
+
+    start = TA1R;
+    write_far_log(FAR_LOG_START, FAR_LOG_COUNT);
+    far_write_cycles = TA1R - start;
+
+    TA1CTL = 0;
+}
+
+long sum_near(const int *table, unsigned int count)
+{
+    long sum = 0;
+
+    while(count != 0)
+    {
+        sum = sum + *table;
+        table = table + 1;
+        count = count - 1;
+    }
+    return sum;
+}
+
+long sum_far(unsigned long from, unsigned int count)
+{
+    long sum = 0;
+
+    while(count != 0)
+    {
+        sum = sum + far_read_int(from);
+        from = from + 2;
+        count = count - 1;
+    }
+    return sum;
+}
+
+long sum_far_blocks(unsigned long from, unsigned int count)
+{
+    int block[BLOCK];
+    long sum = 0;
+
+    while(count != 0)                               // TABLE_SIZE is a multiple of BLOCK
+    {
+        far_copy(block, from, BLOCK);
+        sum = sum + sum_near(block, BLOCK);
+        from = from + 2 * BLOCK;
+        count = count - BLOCK;
+    }
+    return sum;
+}
+
+void copy_near(int *to, const int *from, unsigned int count)
+{
+    while(count != 0)
+    {
+        *to = *from;
+        to = to + 1;
+        from = from + 1;
+        count = count - 1;
+    }
+}
+
+void write_far_log(unsigned long to, unsigned int count)
+{
+    unsigned int i;
+
+    far_unprotect();
+    for(i = 0; i < count; i = i + 1)
+    {
+        far_write_int(to, i ^ 0x5A5A);
+        to = to + 2;
+    }
+    far_protect();
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
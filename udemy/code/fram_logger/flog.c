@@ -0,0 +1,415 @@
+/*
+ * flog.c - the head slots, packing, 20-bit FRAM2 access and the DMA dump for flog.h
+ */
+
+#include <msp430.h>
+#include "flog.h"
+
+#define FLOG_CHECK_START        0xF10C              // Check value of an empty slot
+
+struct flog_slot
+{
+    unsigned int sequence;                          // Bigger is newer
+    unsigned long head;
+    unsigned long records;
+    unsigned int check;                             // Written last
+};
+
+#pragma PERSISTENT(flog_slots)
+volatile struct flog_slot flog_slots[2] = {{0}};    // volatile - the stores must happen in order
+
+unsigned long flog_head;
+unsigned long flog_records;
+unsigned long flog_writes;
+
+#if FLOG_TEST
+unsigned char flog_cut_at;
+#define FLOG_CUT(point)         if(flog_cut_at == (point)) { PMMCTL0 = PMMPW | PMMSWBOR; }
+#else
+#define FLOG_CUT(point)
+#endif
+
+static unsigned char flog_slot;                     // Newest good slot
+static unsigned int flog_sequence;
+static struct flog_record flog_open;                // Being filled
+static unsigned int flog_mpu_sam;
+static volatile unsigned char flog_dma_done;
+
+#if FLOG_COMPRESS
+static unsigned long flog_last_time;
+static int flog_last_sample;
+
+static unsigned char flog_varint(unsigned char *to, unsigned long value);
+static unsigned long flog_read_varint(struct flog_cursor *cursor);
+#endif
+
+static unsigned int flog_check(const volatile struct flog_slot *slot);
+static void flog_write(const struct flog_record *record);
+static void flog_commit(unsigned long head, unsigned long records);
+static unsigned long flog_oldest(void);
+static void flog_unprotect(void);
+static void flog_protect(void);
+static void flog_send(unsigned char data);
+static void flog_dma(unsigned long from, unsigned int bytes);
+
+void flog_init(void)
+{
+    unsigned char good0 = (flog_slots[0].check == flog_check(&flog_slots[0]));
+    unsigned char good1 = (flog_slots[1].check == flog_check(&flog_slots[1]));
+
+    if(good0 && (!good1 || (flog_slots[0].sequence - flog_slots[1].sequence < 0x8000)))
+    {
+        flog_slot = 0;
+    }
+    else if(good1)
+    {
+        flog_slot = 1;
+    }
+    else                                            // Never written (or erased)
+    {
+        flog_slot = 1;                              // The first record goes in slot 0
+        flog_sequence = 0;
+        flog_head = FLOG_START;
+        flog_records = 0;
+    }
+
+    if(good0 || good1)
+    {
+        flog_sequence = flog_slots[flog_slot].sequence;
+        flog_head = flog_slots[flog_slot].head;
+        flog_records = flog_slots[flog_slot].records;
+    }
+
+    flog_open.count = 0;
+    flog_writes = 0;
+}
+
+void flog_erase(void)
+{
+    flog_slots[0].check = 0;
+    flog_slots[1].check = 0;
+    flog_init();
+}
+
+void flog_append(unsigned long time, int sample)
+{
+#if FLOG_COMPRESS
+    unsigned char packed[8];
+    unsigned char bytes;
+    unsigned char i;
+    unsigned int change;
+
+    if((flog_open.count != 0) && (flog_open.count < FLOG_MAX_COUNT))
+    {
+        bytes = flog_varint(packed, time - flog_last_time);
+        change = (unsigned int)sample - (unsigned int)flog_last_sample;
+        change = (change << 1) ^ (unsigned int)((int)change >> 15);    // Zig-zag
+        bytes = bytes + flog_varint(&packed[bytes], change);
+
+        if(flog_open.used + bytes <= FLOG_DATA_SIZE) // Still room in this record
+        {
+            for(i = 0; i < bytes; i = i + 1)
+            {
+                flog_open.data[flog_open.used + i] = packed[i];
+            }
+            flog_open.used = flog_open.used + bytes;
+            flog_open.count = flog_open.count + 1;
+            flog_last_time = time;
+            flog_last_sample = sample;
+            return;
+        }
+    }
+    flog_flush();
+#endif
+
+    flog_open.time = time;                          // A new record
+    flog_open.first = sample;
+    flog_open.count = 1;
+    flog_open.used = 0;
+
+#if FLOG_COMPRESS
+    flog_last_time = time;
+    flog_last_sample = sample;
+#else
+    flog_flush();
+#endif
+}
+
+void flog_flush(void)
+{
+    if(flog_open.count != 0)
+    {
+        flog_write(&flog_open);
+        flog_open.count = 0;
+    }
+}
+
+void flog_first(struct flog_cursor *cursor)
+{
+    cursor->record = flog_oldest();
+    cursor->left = flog_records;
+    cursor->index = 0;
+    cursor->count = 0;                              // Nothing read yet
+}
+
+unsigned char flog_next(struct flog_cursor *cursor, unsigned long *time, int *sample)
+{
+#if FLOG_COMPRESS
+    unsigned int change;
+#endif
+
+    if(cursor->index == cursor->count)              // On to the next record
+    {
+        if(cursor->left == 0)
+        {
+            return 0;
+        }
+        if(cursor->count != 0)
+        {
+            cursor->record = cursor->record + FLOG_RECORD_SIZE;
+            if(cursor->record == FLOG_END)
+            {
+                cursor->record = FLOG_START;
+            }
+        }
+        cursor->left = cursor->left - 1;
+        cursor->time = __data20_read_long(cursor->record);
+        cursor->sample = __data20_read_short(cursor->record + 4);
+        cursor->count = __data20_read_char(cursor->record + 6);
+        cursor->offset = 0;
+        cursor->index = 1;
+    }
+    else
+    {
+#if FLOG_COMPRESS
+        cursor->time = cursor->time + flog_read_varint(cursor);
+        change = (unsigned int)flog_read_varint(cursor);
+        change = (change >> 1) ^ (0 - (change & 1)); // Zig-zag back
+        cursor->sample = (int)((unsigned int)cursor->sample + change);
+#endif
+        cursor->index = cursor->index + 1;
+    }
+
+    *time = cursor->time;
+    *sample = cursor->sample;
+    return 1;
+}
+
+void flog_dump(void)
+{
+    unsigned long oldest = flog_oldest();
+    unsigned long bytes = flog_records * FLOG_RECORD_SIZE;
+    unsigned long to_end = FLOG_END - oldest;
+    unsigned char i;
+
+    flog_send(FLOG_DUMP_START);
+    flog_send('F');
+    flog_send(FLOG_RECORD_SIZE);
+    for(i = 0; i < 32; i = i + 8)
+    {
+        flog_send(flog_records >> i);
+    }
+
+    if(to_end > bytes)
+    {
+        to_end = bytes;
+    }
+    _BIS_SR(GIE);
+    flog_dma(oldest, to_end);                       // Oldest up to the end of FRAM2...
+    flog_dma(FLOG_START, bytes - to_end);           // ...and the rest from the start
+}
+
+// ****************************************************
+// Writing a record, then moving the head
+// ****************************************************
+static void flog_write(const struct flog_record *record)
+{
+    const unsigned int *word = (const unsigned int *)record;
+    unsigned long address = flog_head;
+    unsigned char i;
+
+    flog_unprotect();
+    for(i = 0; i < FLOG_RECORD_SIZE / 2; i = i + 1)
+    {
+        __data20_write_short(address, word[i]);
+        address = address + 2;
+        if(i == FLOG_RECORD_SIZE / 4)
+        {
+            FLOG_CUT(1);                            // Half a record
+        }
+    }
+    flog_protect();
+    FLOG_CUT(2);                                    // Whole record, head not moved
+
+    if(address == FLOG_END)
+    {
+        address = FLOG_START;
+    }
+    if(flog_records < FLOG_MAX_RECORDS)
+    {
+        flog_commit(address, flog_records + 1);
+    }
+    else
+    {
+        flog_commit(address, FLOG_MAX_RECORDS);     // Full - the oldest record is now the free one
+    }
+    flog_writes = flog_writes + 1;
+}
+
+static void flog_commit(unsigned long head, unsigned long records)
+{
+    volatile struct flog_slot *older = &flog_slots[flog_slot ^ 1];
+
+    older->check = 0;                               // Not valid while we write it
+    FLOG_CUT(3);
+    older->head = head;
+    older->records = records;
+    FLOG_CUT(4);
+    older->sequence = flog_sequence + 1;
+    older->check = flog_check(older);               // Now it is
+
+    flog_slot = flog_slot ^ 1;
+    flog_sequence = flog_sequence + 1;
+    flog_head = head;
+    flog_records = records;
+    FLOG_CUT(5);                                    // The record is in the log
+}
+
+static unsigned int flog_check(const volatile struct flog_slot *slot)
+{
+    unsigned int word[4];
+    unsigned int check = FLOG_CHECK_START ^ slot->sequence;
+    unsigned char i;
+
+    word[0] = slot->head;
+    word[1] = slot->head >> 16;
+    word[2] = slot->records;
+    word[3] = slot->records >> 16;
+    for(i = 0; i < 4; i = i + 1)
+    {
+        check = (check << 1) + (check >> 15) + word[i]; // Rotate and add
+    }
+    return check;
+}
+
+static unsigned long flog_oldest(void)
+{
+    unsigned long oldest = flog_head - flog_records * FLOG_RECORD_SIZE;
+
+    if(oldest < FLOG_START)
+    {
+        oldest = oldest + (FLOG_END - FLOG_START);
+    }
+    return oldest;
+}
+
+// ****************************************************
+// MPU segment 3 (FRAM2) - writable only while we write
+// ****************************************************
+static void flog_unprotect(void)
+{
+    if(MPUCTL0 & MPUENA)
+    {
+        MPUCTL0 = MPUPW | (MPUCTL0 & 0x00FF);       // Unlock
+        flog_mpu_sam = MPUSAM;
+        MPUSAM = MPUSAM | MPUSEG3WE;
+    }
+}
+
+static void flog_protect(void)
+{
+    if(MPUCTL0 & MPUENA)
+    {
+        MPUSAM = flog_mpu_sam;
+        MPUCTL0_H = 0x00;                           // Lock again
+    }
+}
+
+#if FLOG_COMPRESS
+// ****************************************************
+// Varints - 7 bits a byte, bit 7 set if more follow
+// ****************************************************
+static unsigned char flog_varint(unsigned char *to, unsigned long value)
+{
+    unsigned char bytes = 0;
+
+    while(value >= 0x80)
+    {
+        to[bytes] = (value & 0x7F) | 0x80;
+        value = value >> 7;
+        bytes = bytes + 1;
+    }
+    to[bytes] = value;
+    return bytes + 1;
+}
+
+static unsigned long flog_read_varint(struct flog_cursor *cursor)
+{
+    unsigned long value = 0;
+    unsigned char shift = 0;
+    unsigned char byte;
+
+    do
+    {
+        byte = __data20_read_char(cursor->record + FLOG_HEADER_SIZE + cursor->offset);
+        cursor->offset = cursor->offset + 1;
+        value = value | ((unsigned long)(byte & 0x7F) << shift);
+        shift = shift + 7;
+    } while((byte & 0x80) && (cursor->offset < FLOG_DATA_SIZE));
+    return value;
+}
+#endif
+
+// ****************************************************
+// UART out - header by hand, records by DMA from FRAM2
+// ****************************************************
+static void flog_send(unsigned char data)
+{
+    while(!(UCA0IFG & UCTXIFG));                    // Wait for room
+    UCA0TXBUF = data;
+}
+
+static void flog_dma(unsigned long from, unsigned int bytes)
+{
+    if(bytes == 0)
+    {
+        return;
+    }
+
+    while(!(UCA0IFG & UCTXIFG));                    // TXBUF empty
+    DMA0CTL = 0;
+    DMACTL0 = DMA0TSEL_15;                          // UCA0TXIFG
+    __data20_write_long((unsigned long)&DMA0SA, from);  // 20-bit source - FRAM2 is fine
+    __data20_write_long((unsigned long)&DMA0DA, (unsigned long)&UCA0TXBUF);
+    DMA0SZ = bytes;
+    DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMASRCBYTE | DMADSTBYTE | DMAEN | DMAIE;
+
+    flog_dma_done = 0;
+    UCA0IFG = UCA0IFG & ~UCTXIFG;                   // The DMA starts on a rising edge
+    UCA0IFG = UCA0IFG | UCTXIFG;                    // of UCTXIFG - make one
+
+    _BIC_SR(GIE);                                   // No lost wake-up between test and sleep
+    while(!flog_dma_done)
+    {
+        _BIS_SR(LPM0_bits | GIE);
+        _BIC_SR(GIE);
+    }
+    _BIS_SR(GIE);
+}
+
+// ****************************************************
+// DMA ISR - channel 0 has sent its block
+// ****************************************************
+#pragma vector=DMA_VECTOR
+__interrupt void FLOG_DMA_ISR(void)
+{
+    switch(__even_in_range(DMAIV, DMAIV_DMA2IFG))
+    {
+        case DMAIV_DMA0IFG:
+        {
+            flog_dma_done = 1;
+            __bic_SR_register_on_exit(LPM0_bits);   // Wake up flog_dma()
+            break;
+        }
+    }
+}
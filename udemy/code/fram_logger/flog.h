@@ -0,0 +1,142 @@
+/*
+ * flog.h - a log of time stamped samples in FRAM2 that survives losing the power
+ *
+ * The RAM is only 2KB and is lost with the power. trace.h keeps its records in the
+ * lower FRAM with #pragma PERSISTENT, but there is much more FRAM above 64KB:
+ *
+ *      FRAM2   0x10000 - 0x23FFF   80KB    (lnk_msp430fr6989.cmd)
+ *
+ * With --data_model=restricted the .cmd file puts the code (.text) there, from 0x10000
+ * up - look for .text in the .map file. flog uses the top 48KB (FLOG_START to FLOG_END).
+ * This project's lnk_msp430fr6989.cmd makes FRAM2 32KB and keeps the rest as FLOG, a
+ * region no section is put in - code that does not fit in 32KB goes to the lower FRAM
+ * (or the link fails), never into the log. The fram_logger CCS project (.cproject) links
+ * with this file; to use flog in another project, copy the FRAM2 and FLOG lines of its
+ * MEMORY list into that project's .cmd file as well. flog reads and writes FRAM2 with the
+ * compiler's 20-bit intrinsics, __data20_read_short(address) and
+ * __data20_write_short(address, value), which work in any data model (even
+ * --data_model=small, where pointers are 16 bits).
+ *
+ * RECORDS
+ * -------
+ * The log is a circular buffer of FLOG_RECORDS fixed-size records, and holds up to
+ * FLOG_MAX_RECORDS (one less). The record at the head is always free, so a new record
+ * never goes over one that is still in the log - when it is full, the oldest record
+ * is dropped only when the new one is committed. Each record is
+ *
+ *      time    4 bytes     time stamp of the first sample (any units - you choose)
+ *      first   2 bytes     the first sample
+ *      count   1 byte      samples in this record
+ *      used    1 byte      bytes of data[] used
+ *      data    8 bytes     (FLOG_COMPRESS only) the other samples, packed
+ *
+ * FLOG_COMPRESS 0 - 8 byte records, one sample in each.
+ * FLOG_COMPRESS 1 - 16 byte records. Samples that change slowly are packed: for each one
+ * after the first, the change in time and the change in the sample are stored as
+ * "varints" - 7 bits in each byte, bit 7 set if another byte follows. The change in the
+ * sample is "zig-zagged" first (0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...) so small
+ * negative changes are small too. A sample taken every 16 ticks that moves by less than
+ * 64 needs 2 bytes instead of 8. The record being filled is in RAM until it is full, or
+ * until flog_flush() - only those samples can be lost with the power.
+ *
+ * LOSING THE POWER
+ * ----------------
+ * The head (where the next record goes) and the number of records are kept in two slots
+ * in the lower FRAM, like the checkpoints in lpm35_checkpoint. A record is added in
+ * this order:
+ *
+ *      1. the record is written at the head - it is not part of the log yet
+ *      2. the OLDER slot gets the new head and count, then its sequence number, and its
+ *         check value LAST
+ *
+ * If the power goes off at any point, flog_init() uses the newest slot with a good
+ * check value. The log is then either what it was before, or has the new record -
+ * never half a record. The FLOG_CUT() points in flog.c are where the self test in
+ * main.c "pulls the plug" (a software brown-out reset).
+ *
+ * MPU
+ * ---
+ * When CCS turns on the Memory Protection Unit, FRAM2 is in segment 3 (code - read and
+ * execute only). flog turns on writing to segment 3 for the few cycles each record
+ * takes, then puts it back. If the MPU is locked (MPULOCK) flog can not write at all.
+ *
+ * DUMP FORMAT
+ * -----------
+ * flog_dump() sends the log out of the UART (P4.2), oldest first. The bytes are sent
+ * straight from FRAM2 by DMA channel 0 (UCA0TXIFG) - nothing is copied, and the CPU
+ * sleeps in LPM0 while they go:
+ *
+ *      0xA5 | 'F' | record size | records (4 bytes, low first) | the records, as above
+ *
+ * (all values in the records are low byte first).
+ */
+
+#ifndef FLOG_H_
+#define FLOG_H_
+
+#include <msp430.h>
+
+#ifndef FLOG_COMPRESS
+#define FLOG_COMPRESS           1                   // 0 - one sample in each 8 byte record
+#endif
+
+#ifndef FLOG_TEST
+#define FLOG_TEST               1                   // 0 - no FLOG_CUT() points
+#endif
+
+#define FLOG_START              0x18000UL           // Top 48KB of FRAM2
+#define FLOG_END                0x24000UL
+#define FLOG_HEADER_SIZE        8
+
+#if FLOG_COMPRESS
+#define FLOG_DATA_SIZE          8
+#else
+#define FLOG_DATA_SIZE          0
+#endif
+
+#define FLOG_RECORD_SIZE        (FLOG_HEADER_SIZE + FLOG_DATA_SIZE)
+#define FLOG_RECORDS            ((FLOG_END - FLOG_START) / FLOG_RECORD_SIZE)
+#define FLOG_MAX_RECORDS        (FLOG_RECORDS - 1)  // The head record is always free
+#define FLOG_MAX_COUNT          255                 // Samples in one record
+#define FLOG_DUMP_START         0xA5                // First byte of a dump
+#define FLOG_CUT_POINTS         5                   // FLOG_CUT(1) to FLOG_CUT(5)
+
+struct flog_record                                  // One record, while it is in RAM
+{
+    unsigned long time;
+    int first;
+    unsigned char count;
+    unsigned char used;
+#if FLOG_COMPRESS
+    unsigned char data[FLOG_DATA_SIZE];
+#endif
+};
+
+struct flog_cursor                                  // For reading the log back
+{
+    unsigned long record;                           // 20-bit address of the record being read
+    unsigned long left;                             // Records not started yet
+    unsigned char index;                            // Samples of this record already read
+    unsigned char count;
+    unsigned char offset;                           // Into data[]
+    unsigned long time;
+    int sample;
+};
+
+extern unsigned long flog_head;                     // 20-bit address of the next record
+extern unsigned long flog_records;                  // Records in the log (up to FLOG_MAX_RECORDS)
+extern unsigned long flog_writes;                   // Records written since flog_init()
+
+#if FLOG_TEST
+extern unsigned char flog_cut_at;                   // 1 to FLOG_CUT_POINTS - reset there
+#endif
+
+void flog_init(void);                               // Finds the head after any reset
+void flog_erase(void);                              // Empty log
+void flog_append(unsigned long time, int sample);
+void flog_flush(void);                              // Writes the record being filled
+void flog_first(struct flog_cursor *cursor);        // Oldest sample
+unsigned char flog_next(struct flog_cursor *cursor, unsigned long *time, int *sample); // 0 - no more
+void flog_dump(void);                               // Uses DMA_VECTOR, turns interrupts on
+
+#endif /* FLOG_H_ */
@@ -0,0 +1,401 @@
+/*
+ * Keeping a history of samples in FRAM2 with flog.h
+ *
+ * Every second the number of S1 (P1.1) presses in that second is added to the log with
+ * a time stamp in seconds. The log is in FRAM2, so the history is still there after the
+ * power has been off. The self test below wipes the log, so it only runs at the first
+ * start after the program is loaded (self_test_done is PERSISTENT, and loading sets it
+ * back to 0). Every start after that carries on with the same log and time stamps.
+ * RUN_SELF_TEST 0 leaves the test out altogether.
+ * Press S2 (P1.2) to send the whole log out of the UART (P4.2, 9600 baud) in the format
+ * described in flog.h.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * Test samples are pattern(n), taken at time n * TIME_STEP, so any sample read back
+ * can be checked on its own, and must come right after the one before it.
+ *
+ *  - cut_errors - the power is "pulled" at each of the FLOG_CUT_POINTS places in a
+ *    write (flog.c), one after the other: flog_cut_at makes flog.c do a software
+ *    brown-out reset (PMMSWBOR) right there. RAM, the CPU and the peripherals start over
+ *    just like after a real power loss; only the FRAM keeps what it had. After each
+ *    reset main() starts again, flog_init() finds the head, and the log must have exactly
+ *    as many records as before (or one more, after FLOG_CUT(5)), the same newest sample
+ *    (or the new one) and every sample must check out. This is done twice (cut_pass):
+ *    with a short log, and with a full log that has gone round, where the new record
+ *    goes in the place of the oldest one. Where we are is kept in FRAM (cut_pass and
+ *    cut_step), so this takes 2 * FLOG_CUT_POINTS + 1 starts of main() - the LEDs blink
+ *    once for each.
+ *
+ *  - Timer1 (1 count = 1 cycle at 8MHz) times each of BENCH_SAMPLES appends, enough
+ *    to go round the log more than once: append_cycles_worst and append_cycles_average
+ *    (the worst is an append that writes a record and moves the head), appends_per_second
+ *    and bytes_per_sample_x100 (FRAM used for each sample, * 100). Then the whole log is
+ *    read back and checked (check_errors).
+ *
+ * Build with FLOG_COMPRESS 0 and 1 in the predefined symbols to compare the two.
+ *
+ * Green LED - all passed (self_test_passed, kept for the later starts too).
+ */
+
+#include <msp430.h>
+#include "flog.h"
+
+#define RUN_SELF_TEST           1                   // Once after loading - 0 for never
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                // Value required to use 9600 baud
+#define CLK_MOD                 0x4911              // uC will "clean up" clock signal
+
+#define TIME_STEP               16                  // Test samples - time n * 16
+#define TIME_SHIFT              4
+#define PREFILL_SAMPLES         20                  // In the log before the first cut
+#define BENCH_SAMPLES           16384
+#define CYCLES_PER_SECOND       8000000UL
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void assign_pins_to_uart(void);                     // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                           // UART operates at 9600 bits per second
+int pattern(unsigned long n);                       // Test sample n
+unsigned int check_log(void);                       // Errors in the whole log
+void power_loss_test(void);                         // Resets us FLOG_CUT_POINTS times
+void run_benchmark(void);
+
+#pragma PERSISTENT(cut_pass)
+unsigned char cut_pass = 0;                         // 0 - short log, 1 - full log
+#pragma PERSISTENT(cut_step)
+unsigned char cut_step = 0;                         // 0 - start the pass again
+#pragma PERSISTENT(cut_before)
+unsigned long cut_before = 0;                       // Records before the plug was pulled
+#pragma PERSISTENT(cut_newest)
+unsigned long cut_newest = 0;                       // Newest sample before the plug was pulled
+#pragma PERSISTENT(cut_errors)
+unsigned int cut_errors = 0;
+#pragma PERSISTENT(self_test_done)
+unsigned char self_test_done = 0;                   // 1 - the log is the demo's, keep it
+#pragma PERSISTENT(self_test_passed)
+unsigned char self_test_passed = 0;
+#pragma PERSISTENT(log_seconds)
+unsigned long log_seconds = 0;                      // Time stamp of the demo samples
+
+unsigned long last_index;                           // Of the newest test sample
+unsigned long checked_samples;
+unsigned int check_errors;
+unsigned int append_cycles_worst;
+unsigned int append_cycles_average;
+unsigned long appends_per_second;
+unsigned int bytes_per_sample_x100;
+
+volatile unsigned char tick;                        // Timer0, every second
+volatile unsigned char presses;                     // S1 this second
+volatile unsigned char dump_request;                // S2
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char count;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED, S1 and S2 inputs
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = BIT0;                                   // Red LED - one blink for each start
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    assign_pins_to_uart();
+    use_9600_baud();
+
+    flog_init();                                    // Where were we?
+    __delay_cycles(800000);                         // 100ms so the blink can be seen
+    P1OUT = 0x00;
+
+#if RUN_SELF_TEST
+    if(!self_test_done)                             // First start after loading
+    {
+        power_loss_test();
+        run_benchmark();
+        self_test_passed = (cut_errors == 0) && (check_errors == 0);
+        flog_erase();                               // The demo starts a new log...
+        log_seconds = 0;
+        self_test_done = 1;                         // ...and keeps it from now on
+    }
+    if(self_test_passed)
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+#endif
+
+    P1REN = BIT2 | BIT1;                            // S1 and S2 pull-ups
+    P1OUT = BIT2 | BIT1;
+    P1IES = BIT2 | BIT1;                            // Pressed - HI to LO
+    P1IFG = 0x00;
+    P1IE = BIT2 | BIT1;
+
+    TA0CCR0 = 40000;                                // 1 second
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+
+    while(1)
+    {
+        _BIC_SR(GIE);                               // No lost wake-up between test and sleep
+        if(!tick && !dump_request)
+        {
+            _BIS_SR(LPM3_bits | GIE);
+        }
+        _BIS_SR(GIE);
+
+        if(tick)
+        {
+            tick = 0;
+            _BIC_SR(GIE);
+            count = presses;
+            presses = 0;
+            _BIS_SR(GIE);
+
+            log_seconds = log_seconds + 1;
+            flog_append(log_seconds, count);
+        }
+        if(dump_request)
+        {
+            dump_request = 0;
+            flog_flush();                           // The record being filled too
+            flog_dump();
+        }
+    }
+}
+
+// ****************************************************
+// Self test - pull the plug at every point of a write
+// ****************************************************
+void power_loss_test(void)
+{
+    unsigned long n;
+    unsigned long newest;
+    unsigned long fill = PREFILL_SAMPLES;
+
+    if(cut_step != 0)                               // We are back from FLOG_CUT(cut_step)
+    {
+        n = cut_before;
+        newest = cut_newest;
+        if(cut_step == FLOG_CUT_POINTS)             // Only the last cut is after the commit
+        {
+            if(n < FLOG_MAX_RECORDS)
+            {
+                n = n + 1;
+            }
+            newest = newest + 1;
+        }
+        if(check_log() != 0)
+        {
+            cut_errors = cut_errors + 1;
+        }
+        if((flog_records != n) || (last_index != newest))
+        {
+            cut_errors = cut_errors + 1;
+        }
+        if(cut_step == FLOG_CUT_POINTS)
+        {
+            cut_step = 0;
+            if(cut_pass != 0)
+            {
+                cut_pass = 0;                       // Done - all over again at the next power up
+                return;
+            }
+            cut_pass = 1;                           // Again, with a full log
+        }
+    }
+
+    if(cut_step == 0)                               // A known log to start with
+    {
+        flog_erase();
+        if(cut_pass == 0)
+        {
+            cut_errors = 0;
+        }
+        else
+        {
+            fill = FLOG_MAX_RECORDS + PREFILL_SAMPLES;  // One sample a record - goes round
+        }
+        for(n = 0; n < fill; n = n + 1)
+        {
+            flog_append(n * TIME_STEP, pattern(n));
+            if(cut_pass != 0)
+            {
+                flog_flush();
+            }
+        }
+        flog_flush();
+    }
+
+    check_log();
+    n = last_index + 1;
+    cut_before = flog_records;
+    cut_newest = last_index;
+    cut_step = cut_step + 1;                        // In FRAM before the plug is pulled
+#if FLOG_TEST
+    flog_cut_at = cut_step;
+#endif
+    flog_append(n * TIME_STEP, pattern(n));
+    flog_flush();                                   // We never come back from this...
+
+#if FLOG_TEST
+    flog_cut_at = 0;                                // ...unless the cut point was missed
+#endif
+    cut_errors = cut_errors + 1;
+    cut_step = 0;
+    cut_pass = 0;
+}
+
+// ****************************************************
+// Benchmark - cycles for one append
+// ****************************************************
+void run_benchmark(void)
+{
+    unsigned long n;
+    unsigned long first;
+    unsigned long total = 0;
+    unsigned int start;
+    unsigned int took;
+    unsigned int i;
+
+    check_log();
+    first = last_index + 1;
+    flog_writes = 0;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    for(i = 0; i < BENCH_SAMPLES; i = i + 1)
+    {
+        n = first + i;
+        start = TA1R;
+        flog_append(n * TIME_STEP, pattern(n));
+        took = TA1R - start;
+
+        total = total + took;
+        if(took > append_cycles_worst)
+        {
+            append_cycles_worst = took;
+        }
+    }
+    flog_flush();
+
+    TA1CTL = 0;
+
+    append_cycles_average = total / BENCH_SAMPLES;
+    appends_per_second = CYCLES_PER_SECOND / append_cycles_average;
+    bytes_per_sample_x100 = (flog_writes * FLOG_RECORD_SIZE * 100) / BENCH_SAMPLES;
+
+    check_errors = check_log();
+    if((flog_records != FLOG_MAX_RECORDS) || (last_index != first + BENCH_SAMPLES - 1))
+    {
+        check_errors = check_errors + 1;            // Must have gone round, and kept the newest
+    }
+}
+
+// ****************************************************
+// Reading the log back - every sample must fit
+// ****************************************************
+unsigned int check_log(void)
+{
+    struct flog_cursor cursor;
+    unsigned long time;
+    unsigned long n;
+    int sample;
+    unsigned int errors = 0;
+
+    checked_samples = 0;
+    flog_first(&cursor);
+    while(flog_next(&cursor, &time, &sample))
+    {
+        n = time >> TIME_SHIFT;
+        if((time & (TIME_STEP - 1)) || (sample != pattern(n)))
+        {
+            errors = errors + 1;
+        }
+        if((checked_samples != 0) && (n != last_index + 1))
+        {
+            errors = errors + 1;                    // Lost or repeated
+        }
+        last_index = n;
+        checked_samples = checked_samples + 1;
+    }
+    return errors;
+}
+
+int pattern(unsigned long n)
+{
+    return 500 + (int)((n * 7) & 63) - 32;          // Moves by less than 64 - packs well
+}
+
+// *************************************************************************
+// Timer0 ISR - one second
+// *************************************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    tick = 1;
+    __bic_SR_register_on_exit(LPM3_bits);           // Wake up main()
+}
+
+// *************************************************************************
+// Port 1 ISR - S1 counts, S2 dumps
+// *************************************************************************
+#pragma vector=PORT1_VECTOR
+__interrupt void Port1_ISR(void)
+{
+    if(P1IFG & BIT1)
+    {
+        presses = presses + 1;
+    }
+    if(P1IFG & BIT2)
+    {
+        dump_request = 1;
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+    P1IFG = 0x00;
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
@@ -0,0 +1,109 @@
+/*
+ * This is isr_challenge_1 (and red_green_p11_p12) written with the pin macros in pins.h
+ *
+ *  - Timer0 interrupt toggles the red LED (P1.0) every second
+ *  - While S1 (P1.1) is pushed, the green LED (P9.7) is on
+ *  - S1 and S2 (P1.2) get their pull-ups with one access to P1OUT and one to P1REN
+ *
+ * Note, the LEDs are on different ports, so PINS_TOGGLE(RED_LED, GREEN_LED) will NOT
+ * compile - you need PIN_TOGGLE(RED_LED); PIN_TOGGLE(GREEN_LED);
+ *
+ * Each pin is only ever changed with |=, &= ~ or ^=, so the P1.1 and P1.2 pull-ups
+ * (which live in P1OUT) are never overwritten when the red LED changes.
+ *
+ * SIZE COMPARISON
+ * ---------------
+ * The MSP430 can change bits in a peripheral register with one instruction (BIS.B, BIC.B
+ * or XOR.B straight on &PxOUT), and that is what each macro asks for. P1 is the low byte
+ * of port A (PAOUT_L) and P9 the low byte of port E (PEOUT_L). The size of each
+ * instruction follows from the instruction set:
+ *
+ *      2 bytes     the instruction word
+ *    + 2 bytes     for an immediate constant, unless it is 0, 1, 2, 4, 8 or -1 (those
+ *                  come free from the "constant generator")
+ *    + 2 bytes     for an &absolute address (every PxOUT, PxIN, PxREN...)
+ *
+ *  C code                              Instructions                        Bytes
+ *  -------------------------------     --------------------------------    -----
+ *  PIN_HIGH(RED_LED)                   BIS.B  #1, &PAOUT_L                   4
+ *  PIN_TOGGLE(RED_LED)                 XOR.B  #1, &PAOUT_L                   4
+ *  PIN_HIGH(GREEN_LED)                 BIS.B  #128, &PEOUT_L                 6
+ *  PIN_LOW(GREEN_LED)                  BIC.B  #128, &PEOUT_L                 6
+ *  PINS_PULL_UP(BUTTON11, BUTTON12)    BIS.B  #6, &PAOUT_L                   6
+ *                                      BIS.B  #6, &PAREN_L                   6
+ *  PIN_READ(BUTTON11) in an if         BIT.B  #2, &PAIN_L                    4
+ *                                      JNE    (to the else)                  2
+ *
+ *  isr_challenge_1                     Instructions                        Bytes
+ *  -------------------------------     --------------------------------    -----
+ *  P1OUT = BIT1;                       MOV.B  #2, &PAOUT_L                   4
+ *  P1REN = BIT1;                       MOV.B  #2, &PAREN_L                   4
+ *  while((BIT1 & P1IN) == 0)           BIT.B  #2, &PAIN_L                    4
+ *                                      JNE    (out of the loop)              2
+ *  P9OUT = BIT7;                       MOV.B  #128, &PEOUT_L                 6
+ *  P9OUT = 0x00;                       CLR.B  &PEOUT_L  (MOV.B #0)           4
+ *  P1OUT = P1OUT ^ BIT0;               XOR.B  #1, &PAOUT_L                   4
+ *
+ * So the macros are no bigger and no faster than the old style - the win is that they
+ * can not touch the other pins. P9OUT = BIT7 also clears P9.0 - P9.6, and
+ * P1OUT = BIT1; P1OUT = BIT2; (one pin at a time) loses the P1.1 pull-up. Pulling up
+ * both buttons costs 12 bytes either way (BIS.B or MOV.B with #6).
+ *
+ * To check the numbers, turn on Build -> MSP430 Compiler -> Advanced Options ->
+ * Assembler Options -> "Generate listing file" (--asm_listing) and open main.lst, or
+ * use View -> Disassembly while debugging.
+ */
+
+#include <msp430.h>
+#include "pins.h"
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define ONE_SECOND              40000               // 40000 * 25us = 1 sec
+
+// Pins on the LaunchPad - port number, then bit
+#define RED_LED                 1, BIT0             // P1.0
+#define GREEN_LED               9, BIT7             // P9.7
+#define BUTTON11                1, BIT1             // P1.1 (S1)
+#define BUTTON12                1, BIT2             // P1.2 (S2)
+
+main()
+{
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    PIN_OUTPUT(RED_LED);                            // P1.0 is an output
+    PIN_OUTPUT(GREEN_LED);                          // P9.7 is an output
+    PIN_LOW(RED_LED);                               // Both LEDs start off
+    PIN_LOW(GREEN_LED);
+
+    PINS_PULL_UP(BUTTON11, BUTTON12);               // Both buttons need a pull-up resistor
+
+    TA0CCR0 = ONE_SECOND;
+    TA0CTL = ACLK | UP;                             // ACLK source in UP mode
+    TA0CCTL0 = CCIE;                                // Enable interrupts for Timer0
+
+    _BIS_SR(GIE);                                   // Activate enabled interrupts
+
+    while(1)
+    {
+        if(PIN_READ(BUTTON11) == 0)                 // Is S1 pushed?
+        {
+            PIN_HIGH(GREEN_LED);
+        }
+        else
+        {
+            PIN_LOW(GREEN_LED);
+        }
+    }
+}
+
+// *************************
+// Timer0 ISR
+// *************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    PIN_TOGGLE(RED_LED);                            // Only P1.0 changes, pull-ups stay put
+}
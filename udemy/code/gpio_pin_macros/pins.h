@@ -0,0 +1,71 @@
+/*
+ * pins.h - pin macros where the port and bit are known when the program is compiled
+ *
+ * Up to now every program has its own #defines for the pins (RED_LED 0x0001,
+ * GREEN_LED 0x0080, BUTTON11 0x0002...) and then writes the whole register, for
+ * example P1OUT = BIT0. Writing the whole register also changes the other 7 pins on
+ * the port, which is how the P1.1 pull-up (set with P1OUT = BIT1) can be lost.
+ *
+ * Here a pin is described by BOTH its port number and its bit, separated by a comma:
+ *
+ *      #define RED_LED         1, BIT0             // P1.0
+ *      #define GREEN_LED       9, BIT7             // P9.7
+ *
+ * The macros glue the port number onto the register name, so PIN_HIGH(GREEN_LED)
+ * becomes (P9OUT |= BIT7). The port and bit are constants, so the compiler turns each
+ * macro into ONE instruction that only changes the pin we asked for:
+ *
+ *      PIN_HIGH(pin)       BIS.B   #bit, &PxOUT        (bit SET)
+ *      PIN_LOW(pin)        BIC.B   #bit, &PxOUT        (bit CLEAR)
+ *      PIN_TOGGLE(pin)     XOR.B   #bit, &PxOUT
+ *      PIN_READ(pin)       BIT.B   #bit, &PxIN         (bit TEST)
+ *
+ * There is no function call, no variable and no RAM used - it costs nothing at run time.
+ *
+ * The PINS_... macros take two pins that must be on the SAME port, and change them
+ * both with a single instruction. If the pins are on different ports the program will
+ * not compile (the array size in PIN_SAME_PORT becomes -1).
+ */
+
+#ifndef PINS_H_
+#define PINS_H_
+
+#include <msp430.h>
+
+// The extra "_" level is needed so RED_LED is replaced by "1, BIT0" BEFORE ## is used
+#define PIN_PORT(pin)                   PIN_PORT_(pin)
+#define PIN_PORT_(port, bit)            (port)
+#define PIN_BIT(pin)                    PIN_BIT_(pin)
+#define PIN_BIT_(port, bit)             (bit)
+
+// One pin
+#define PIN_OUTPUT(pin)                 PIN_OUTPUT_(pin)
+#define PIN_OUTPUT_(port, bit)          (P##port##DIR |= (bit))
+#define PIN_INPUT(pin)                  PIN_INPUT_(pin)
+#define PIN_INPUT_(port, bit)           (P##port##DIR &= ~(bit))
+#define PIN_PULL_UP(pin)                PIN_PULL_UP_(pin)
+#define PIN_PULL_UP_(port, bit)         (P##port##OUT |= (bit), P##port##REN |= (bit))
+#define PIN_HIGH(pin)                   PIN_HIGH_(pin)
+#define PIN_HIGH_(port, bit)            (P##port##OUT |= (bit))
+#define PIN_LOW(pin)                    PIN_LOW_(pin)
+#define PIN_LOW_(port, bit)             (P##port##OUT &= ~(bit))
+#define PIN_TOGGLE(pin)                 PIN_TOGGLE_(pin)
+#define PIN_TOGGLE_(port, bit)          (P##port##OUT ^= (bit))
+#define PIN_READ(pin)                   PIN_READ_(pin)
+#define PIN_READ_(port, bit)            (P##port##IN & (bit))
+
+// Two pins on the same port, one register access
+#define PIN_SAME_PORT(p1, p2)           ((void)sizeof(char[((p1) == (p2)) ? 1 : -1]))
+#define PINS_OUTPUT(a, b)               PINS_OUTPUT_(a, b)
+#define PINS_OUTPUT_(p1, b1, p2, b2)    (PIN_SAME_PORT(p1, p2), P##p1##DIR |= ((b1) | (b2)))
+#define PINS_PULL_UP(a, b)              PINS_PULL_UP_(a, b)
+#define PINS_PULL_UP_(p1, b1, p2, b2)   (PIN_SAME_PORT(p1, p2), P##p1##OUT |= ((b1) | (b2)), \
+                                         P##p1##REN |= ((b1) | (b2)))
+#define PINS_HIGH(a, b)                 PINS_HIGH_(a, b)
+#define PINS_HIGH_(p1, b1, p2, b2)      (PIN_SAME_PORT(p1, p2), P##p1##OUT |= ((b1) | (b2)))
+#define PINS_LOW(a, b)                  PINS_LOW_(a, b)
+#define PINS_LOW_(p1, b1, p2, b2)       (PIN_SAME_PORT(p1, p2), P##p1##OUT &= ~((b1) | (b2)))
+#define PINS_TOGGLE(a, b)               PINS_TOGGLE_(a, b)
+#define PINS_TOGGLE_(p1, b1, p2, b2)    (PIN_SAME_PORT(p1, p2), P##p1##OUT ^= ((b1) | (b2)))
+
+#endif /* PINS_H_ */
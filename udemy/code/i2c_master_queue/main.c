@@ -0,0 +1,491 @@
+/*
+ * Interrupt driven I2C master on eUSCI_B0 with a transaction queue
+ *
+ * I2C uses only two wires for many devices: SDA (data) and SCL (clock). Every device
+ * has a 7-bit address, and most sensors are read like this:
+ *
+ *   START | address+W | register | RESTART | address+R | data ... | STOP
+ *
+ * At 100kHz one byte takes 90us, so reading a few registers by waiting for each flag
+ * would stop the CPU for hundreds of microseconds. Here the whole transaction is done
+ * by the eUSCI_B0 ISR, one step per interrupt:
+ *
+ *  - i2c_submit() puts a struct i2c_transaction in a queue and returns straight away
+ *  - The ISR sends the register, does the RESTART, and moves the data
+ *  - UCB0TBCNT is loaded with the number of data bytes and UCASTP_2 is set, so the
+ *    eUSCI sends the STOP by itself after the last byte - no need to be on time for it
+ *  - When the STOP has gone out (UCSTPIFG) the ISR starts the next transaction
+ *
+ * If the device does not answer its address (NACK) we send a STOP and the transaction
+ * finishes with I2C_NACK. Timer0 CCR1 is set I2C_TIMEOUT_TICKS ahead every time a
+ * transaction starts. If it goes off first, something is holding the bus: the eUSCI is
+ * reset, 9 clocks are sent on SCL to free a device stuck in the middle of a byte, and
+ * the transaction finishes with I2C_TIMEOUT.
+ *
+ * Reads of any length (even one byte) use the automatic STOP too. The ISR asks for the
+ * RESTART as soon as the register byte is in the shift register, and a START clears the
+ * byte counter, so only the data bytes after the RESTART are counted. Nothing waits.
+ *
+ *      P1.6  UCB0SDA         P1.7  UCB0SCL         (master)
+ *      P4.0  UCB1SDA         P4.1  UCB1SCL         (test slave)
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * eUSCI_B1 is set up as a simple I2C slave at SLAVE_ADDRESS with 16 registers: the first
+ * byte written is the register number, and each byte after that is written to (or read
+ * from) the next register. Connect P1.6 to P4.0 and P1.7 to P4.1 and add a 4.7k pull-up
+ * resistor from each wire to 3.3V.
+ *
+ * i2c_ok is 1 if registers written by the master read back the same (four at once and
+ * one on its own), and a NACK from an address nobody uses is reported as I2C_NACK. Then
+ * BENCH_TRANSACTIONS two byte register reads are queued at 100kHz and at 400kHz and
+ * timed with Timer1 (SMCLK / 8 = 1us per count). The results are in
+ * transactions_per_second[].
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE                          // Required to use inputs and outputs
+#define ACLK                    0x0100                          // Timer_A ACLK source
+#define SMCLK                   0x0200                          // Timer_A SMCLK source
+#define CONTINUOUS              0x0020                          // Timer_A CONTINUOUS mode
+
+#define I2C_100KHZ              80                              // 8MHz / 80 = 100kHz
+#define I2C_400KHZ              20                              // 8MHz / 20 = 400kHz
+#define I2C_QUEUE_SIZE          8                               // Must be a power of 2
+#define I2C_TIMEOUT_TICKS       400                             // 400 * 25us = 10ms
+
+#define I2C_WAITING             0                               // Values of status
+#define I2C_DONE                1
+#define I2C_NACK                2
+#define I2C_TIMEOUT             3
+
+#define I2C_WRITE               0                               // Values of direction
+#define I2C_READ                1
+
+#define SLAVE_ADDRESS           0x48
+#define NOBODY_ADDRESS          0x77                            // Nothing answers here
+#define SLAVE_REGISTERS         16
+#define NUMBER_OF_SPEEDS        2
+#define BENCH_TRANSACTIONS      16
+
+struct i2c_transaction
+{
+    unsigned char address;                                      // 7-bit device address
+    unsigned char direction;                                    // I2C_WRITE or I2C_READ
+    unsigned char reg;                                          // Register number sent first
+    unsigned char *data;
+    unsigned char length;                                       // 1 to 255 data bytes
+    volatile unsigned char status;                              // I2C_WAITING until finished
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                                // Assigns uC clock signals
+void i2c_init(unsigned int divider);                            // Pins, speed and timeout timer
+unsigned char i2c_submit(struct i2c_transaction *transaction);  // 0 if the queue is full
+void i2c_wait(struct i2c_transaction *transaction);
+void i2c_start_next(void);                                      // Called with interrupts off
+void i2c_finish(unsigned char status);
+void i2c_recover_bus(void);                                     // 9 clocks on SCL
+void slave_init(void);                                          // eUSCI_B1 test slave
+unsigned int run_benchmark(unsigned int divider);
+
+struct i2c_transaction *queue[I2C_QUEUE_SIZE];                  // Waiting transactions
+volatile unsigned char queue_head;                              // Next to start (ISR)
+volatile unsigned char queue_tail;                              // Next free place (i2c_submit)
+struct i2c_transaction * volatile active;                       // On the bus now, 0 if idle
+unsigned int bus_divider;                                       // I2C_100KHZ or I2C_400KHZ
+unsigned char register_sent;                                    // Progress of the active transaction
+unsigned char count;
+unsigned char nacked;
+
+unsigned char slave_registers[SLAVE_REGISTERS];                 // The test slave
+unsigned char slave_pointer;
+unsigned char slave_first_byte;
+
+unsigned char i2c_ok;
+unsigned int nack_status;
+unsigned int transactions_per_second[NUMBER_OF_SPEEDS];         // [0] 100kHz, [1] 400kHz
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    struct i2c_transaction write;
+    struct i2c_transaction read;
+    struct i2c_transaction single;
+    struct i2c_transaction nobody;
+    unsigned char out[4] = {0x12, 0x34, 0x56, 0x78};
+    unsigned char in[4] = {0, 0, 0, 0};
+    unsigned char single_in = 0;
+    unsigned char i;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable inputs and outputs
+
+    P1DIR = BIT0;                                               // Red LED
+    P9DIR = BIT7;                                               // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                                     // SMCLK = 8MHz
+    slave_init();
+    i2c_init(I2C_100KHZ);
+    _BIS_SR(GIE);
+
+    write.address = SLAVE_ADDRESS;                              // Registers 3 to 6 = out[]
+    write.direction = I2C_WRITE;
+    write.reg = 3;
+    write.data = out;
+    write.length = 4;
+
+    read.address = SLAVE_ADDRESS;                               // Read them back
+    read.direction = I2C_READ;
+    read.reg = 3;
+    read.data = in;
+    read.length = 4;
+
+    single.address = SLAVE_ADDRESS;                             // One byte - register 5 = out[2]
+    single.direction = I2C_READ;
+    single.reg = 5;
+    single.data = &single_in;
+    single.length = 1;
+
+    nobody.address = NOBODY_ADDRESS;                            // Must NACK
+    nobody.direction = I2C_READ;
+    nobody.reg = 0;
+    nobody.data = in;
+    nobody.length = 1;
+
+    i2c_submit(&write);                                         // All four queued at once
+    i2c_submit(&read);
+    i2c_submit(&single);
+    i2c_submit(&nobody);
+    i2c_wait(&nobody);                                          // They finish in order
+
+    i2c_ok = (write.status == I2C_DONE) && (read.status == I2C_DONE) &&
+             (single.status == I2C_DONE) && (single_in == out[2]);
+    for(i = 0; i < 4; i = i + 1)
+    {
+        if(in[i] != out[i])
+        {
+            i2c_ok = 0;
+        }
+    }
+    nack_status = nobody.status;
+    if(nack_status != I2C_NACK)
+    {
+        i2c_ok = 0;
+    }
+
+    transactions_per_second[0] = run_benchmark(I2C_100KHZ);
+    transactions_per_second[1] = run_benchmark(I2C_400KHZ);
+
+    if(i2c_ok)
+    {
+        P9OUT = BIT7;                                           // Green - everything worked
+    }
+    else
+    {
+        P1OUT = BIT0;                                           // Red - check the wires and pull-ups
+    }
+
+    while(1);
+}
+
+// ****************************************************
+// I2C master driver
+// ****************************************************
+void i2c_init(unsigned int divider)
+{
+    P1SEL1 = P1SEL1 & ~(BIT6 | BIT7);
+    P1SEL0 = P1SEL0 | BIT6 | BIT7;                              // SDA and SCL to eUSCI_B0
+
+    bus_divider = divider;
+    active = 0;
+    queue_head = 0;
+    queue_tail = 0;
+
+    UCB0CTLW0 = UCSWRST | UCMODE_3 | UCMST | UCSYNC | UCSSEL__SMCLK;
+
+    TA0CTL = ACLK | CONTINUOUS | TACLR;                         // Timeout timer, 25us per count
+}
+
+unsigned char i2c_submit(struct i2c_transaction *transaction)
+{
+    unsigned char next = (queue_tail + 1) & (I2C_QUEUE_SIZE - 1);
+
+    if(next == queue_head)
+    {
+        return 0;                                               // Full
+    }
+    transaction->status = I2C_WAITING;
+    queue[queue_tail] = transaction;
+    queue_tail = next;                                          // Only now can the ISR see it
+
+    _BIC_SR(GIE);                                               // The ISR must not start one too
+    if(active == 0)
+    {
+        i2c_start_next();
+    }
+    _BIS_SR(GIE);
+    return 1;
+}
+
+void i2c_wait(struct i2c_transaction *transaction)
+{
+    _BIC_SR(GIE);                                               // So the ISR can not finish between
+    while(transaction->status == I2C_WAITING)                   // the check and going to sleep
+    {
+        _BIS_SR(LPM0_bits | GIE);                               // The ISR wakes us
+        _BIC_SR(GIE);
+    }
+    _BIS_SR(GIE);
+}
+
+void i2c_start_next(void)
+{
+    struct i2c_transaction *transaction;
+
+    if(queue_head == queue_tail)
+    {
+        active = 0;                                             // Nothing waiting
+        return;
+    }
+    transaction = queue[queue_head];
+    queue_head = (queue_head + 1) & (I2C_QUEUE_SIZE - 1);
+    active = transaction;
+    register_sent = 0;
+    count = 0;
+    nacked = 0;
+
+    // UCB0TBCNT and UCASTP can only be changed while the eUSCI is held in reset
+    UCB0CTLW0 = UCSWRST | UCMODE_3 | UCMST | UCSYNC | UCSSEL__SMCLK;
+    UCB0BRW = bus_divider;
+    UCB0I2CSA = transaction->address;
+    if(transaction->direction == I2C_WRITE)
+    {
+        UCB0CTLW1 = UCASTP_2;                                   // STOP after register + data
+        UCB0TBCNT = transaction->length + 1;
+    }
+    else
+    {
+        UCB0CTLW1 = UCASTP_2;                                   // RESTART clears the count, so
+        UCB0TBCNT = transaction->length;                        // only the data bytes are counted
+    }
+    UCB0CTLW0 = UCB0CTLW0 & ~UCSWRST;
+
+    UCB0IE = UCTXIE0 | UCRXIE0 | UCNACKIE | UCSTPIE;
+    TA0CCR1 = TA0R + I2C_TIMEOUT_TICKS;                         // Give up if no STOP by then
+    TA0CCTL1 = CCIE;
+    UCB0CTLW0 = UCB0CTLW0 | UCTR | UCTXSTT;                     // START + address + W
+}
+
+void i2c_finish(unsigned char status)
+{
+    TA0CCTL1 = 0;                                               // Timeout off
+    UCB0IE = 0;
+    active->status = status;
+    i2c_start_next();
+}
+
+void i2c_recover_bus(void)
+{
+    unsigned char i;
+
+    UCB0CTLW0 = UCB0CTLW0 | UCSWRST;                            // Let go of the pins
+    P1OUT = P1OUT & ~BIT7;
+    P1SEL0 = P1SEL0 & ~BIT7;                                    // SCL is a pin we control for now
+    for(i = 0; i < 9; i = i + 1)                                // Enough clocks to finish any byte
+    {
+        P1DIR = P1DIR | BIT7;                                   // Pull SCL LO...
+        __delay_cycles(40);
+        P1DIR = P1DIR & ~BIT7;                                  // ...and let the pull-up take it HI
+        __delay_cycles(40);
+    }
+    P1SEL0 = P1SEL0 | BIT7;                                     // Back to the eUSCI
+}
+
+// ****************************************************
+// eUSCI_B0 ISR - one step of the active transaction
+// ****************************************************
+#pragma vector=USCI_B0_VECTOR
+__interrupt void I2C_Master_ISR(void)
+{
+    switch(__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG))
+    {
+        case USCI_I2C_UCNACKIFG:                                // Nobody answered
+        {
+            nacked = 1;
+            UCB0CTLW0 = UCB0CTLW0 | UCTXSTP;                    // Finish on UCSTPIFG
+            break;
+        }
+
+        case USCI_I2C_UCSTPIFG:                                 // STOP has gone out
+        {
+            if(nacked)
+            {
+                i2c_finish(I2C_NACK);
+            }
+            else
+            {
+                i2c_finish(I2C_DONE);
+            }
+            __bic_SR_register_on_exit(LPM0_bits);               // Wake up main()
+            break;
+        }
+
+        case USCI_I2C_UCRXIFG0:                                 // A data byte came in
+        {
+            active->data[count] = UCB0RXBUF;
+            count = count + 1;
+            break;
+        }
+
+        case USCI_I2C_UCTXIFG0:                                 // Room for the next byte
+        {
+            if(!register_sent)
+            {
+                UCB0TXBUF = active->reg;
+                register_sent = 1;
+            }
+            else if(active->direction == I2C_READ)
+            {
+                UCB0IE = UCB0IE & ~UCTXIE0;                     // Nothing more to send
+                UCB0CTLW0 = (UCB0CTLW0 & ~UCTR) | UCTXSTT;      // RESTART + address + R, then
+                                                                // UCB0TBCNT sends the STOP
+            }
+            else if(count < active->length)
+            {
+                UCB0TXBUF = active->data[count];
+                count = count + 1;
+            }
+            else
+            {
+                UCB0IE = UCB0IE & ~UCTXIE0;                     // UCB0TBCNT sends the STOP
+            }
+            break;
+        }
+    }
+}
+
+// ****************************************************
+// Timer0 CCR1 ISR - the bus is stuck
+// ****************************************************
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt void Timeout_ISR(void)
+{
+    switch(__even_in_range(TA0IV, TA0IV_TAIFG))
+    {
+        case TA0IV_TACCR1:
+        {
+            if(active)
+            {
+                i2c_recover_bus();
+                i2c_finish(I2C_TIMEOUT);                        // Also starts the next one
+            }
+            __bic_SR_register_on_exit(LPM0_bits);
+            break;
+        }
+    }
+}
+
+// ****************************************************
+// Test slave on eUSCI_B1
+// ****************************************************
+void slave_init(void)
+{
+    P4SEL1 = P4SEL1 & ~(BIT0 | BIT1);
+    P4SEL0 = P4SEL0 | BIT0 | BIT1;                              // SDA and SCL to eUSCI_B1
+
+    UCB1CTLW0 = UCSWRST | UCMODE_3 | UCSYNC;                    // I2C slave
+    UCB1I2COA0 = SLAVE_ADDRESS | UCOAEN;
+    UCB1CTLW0 = UCB1CTLW0 & ~UCSWRST;
+    UCB1IE = UCSTTIE | UCRXIE0 | UCTXIE0;
+}
+
+#pragma vector=USCI_B1_VECTOR
+__interrupt void I2C_Slave_ISR(void)
+{
+    switch(__even_in_range(UCB1IV, USCI_I2C_UCBIT9IFG))
+    {
+        case USCI_I2C_UCSTTIFG:                                 // We were addressed
+        {
+            slave_first_byte = 1;
+            break;
+        }
+
+        case USCI_I2C_UCRXIFG0:
+        {
+            if(slave_first_byte)                                // Register number
+            {
+                slave_pointer = UCB1RXBUF & (SLAVE_REGISTERS - 1);
+                slave_first_byte = 0;
+            }
+            else
+            {
+                slave_registers[slave_pointer] = UCB1RXBUF;
+                slave_pointer = (slave_pointer + 1) & (SLAVE_REGISTERS - 1);
+            }
+            break;
+        }
+
+        case USCI_I2C_UCTXIFG0:
+        {
+            UCB1TXBUF = slave_registers[slave_pointer];
+            slave_pointer = (slave_pointer + 1) & (SLAVE_REGISTERS - 1);
+            break;
+        }
+    }
+}
+
+// ****************************************************
+// Benchmark - two byte register reads, back to back
+// ****************************************************
+unsigned int run_benchmark(unsigned int divider)
+{
+    struct i2c_transaction bench[BENCH_TRANSACTIONS];
+    unsigned char data[2];
+    unsigned int start;
+    unsigned int microseconds;
+    unsigned char i;
+
+    bus_divider = divider;
+    for(i = 0; i < BENCH_TRANSACTIONS; i = i + 1)
+    {
+        bench[i].address = SLAVE_ADDRESS;
+        bench[i].direction = I2C_READ;
+        bench[i].reg = i;
+        bench[i].data = data;
+        bench[i].length = 2;
+    }
+
+    TA1CTL = SMCLK | ID_3 | CONTINUOUS | TACLR;                 // 8MHz / 8 = 1us per count
+    start = TA1R;
+    for(i = 0; i < BENCH_TRANSACTIONS; i = i + 1)
+    {
+        while(!i2c_submit(&bench[i]))                           // Queue full - wait for room
+        {
+            i2c_wait(&bench[i - (I2C_QUEUE_SIZE - 1)]);
+        }
+    }
+    i2c_wait(&bench[BENCH_TRANSACTIONS - 1]);
+    microseconds = TA1R - start;
+    TA1CTL = 0;
+
+    return ((unsigned long)BENCH_TRANSACTIONS * 1000000) / microseconds;
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
@@ -0,0 +1,310 @@
+/*
+ * One way of handling every "shared" interrupt vector.
+ *
+ * Some peripherals have many interrupt flags but only ONE interrupt vector:
+ *  - TIMER0_A1_VECTOR is used by TA0CCR1, TA0CCR2 and the timer overflow (TAIFG)
+ *  - PORT1_VECTOR is used by all 8 pins of Port 1
+ *  - USCI_A0_VECTOR is used by the UART receive, transmit, start bit and TX complete flags
+ *
+ * Earlier programs each did this a different way: timer0_semi_atuo_pwm tests
+ * "if (TA0IV == 2)", red_green_p11_p12 uses switch(P1IV), and the UART programs test
+ * UCA0IFG and then clear the flag by hand.
+ *
+ * Here every shared vector is handled the same way:
+ *
+ *  1. The Interrupt Vector register (TA0IV, P1IV or UCA0IV) is read ONCE. Reading it
+ *     tells us the highest priority flag that is set (as 0, 2, 4, 6...) AND clears
+ *     that flag for us, so there is no need to clear flags by hand.
+ *
+ *  2. __even_in_range(value, largest) tells the compiler the value can only be an even
+ *     number from 0 to largest. Without it the compiler has to check for odd numbers.
+ *
+ *  3. value / 2 is used as the index into a table of functions (a "jump table"). It
+ *     takes the same time to find the right function for the first flag or the last.
+ *
+ * The main program "registers" which function should run for each flag using
+ * register_handler(). Flags nobody registered go to no_handler() which does nothing.
+ *
+ * BENCHMARK
+ * ---------
+ * At start-up, each vector is triggered by software (setting the flag ourselves) and
+ * Timer1, running from SMCLK = MCLK = 8MHz, measures the number of CPU cycles from
+ * just before the flag is set until the first line of the handler runs. The smallest
+ * and largest of BENCH_TRIALS tries are kept in latency_min[] and latency_max[] so they
+ * can be looked at in the debugger. Setting the flag and reading TA1R are included in
+ * the number, so compare the peripherals with each other rather than the datasheet.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                // Value required to use 9600 baud
+#define CLK_MOD                 0x4911              // uC will "clean up" clock signal
+#define BENCH_TRIALS            16                  // Tries per peripheral
+
+// How many entries each table needs - largest IV value / 2, plus one for "no interrupt"
+#define TIMER_A_HANDLERS        ((TA0IV_TAIFG / 2) + 1)
+#define PORT_HANDLERS           ((P1IV_P1IFG7 / 2) + 1)
+#define UART_HANDLERS           ((UCIV__UCTXCPTIFG / 2) + 1)
+
+// Peripherals in the benchmark
+#define BENCH_TIMER             0
+#define BENCH_PORT              1
+#define BENCH_UART              2
+#define NUMBER_OF_BENCHES       3
+
+typedef void (*isr_handler)(void);
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                                // Assigns uC clock signals
+void assign_pins_to_uart(void);                                 // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                                       // UART operates at 9600 bits per second
+void no_handler(void);                                          // Used for flags nobody registered
+void register_handler(isr_handler *table, unsigned int iv_value, isr_handler handler);
+void run_benchmark(void);                                       // Fills latency_min[] and latency_max[]
+void bench_trigger(unsigned char bench);                        // Sets one flag by software
+void bench_stamp(void);                                         // Handler used by the benchmark
+void red_led_on(void);                                          // Application handlers
+void red_led_off(void);
+void toggle_green_led(void);
+void uart_received(void);
+
+isr_handler timer0_a1_handlers[TIMER_A_HANDLERS];               // Indexed by TA0IV / 2
+isr_handler port1_handlers[PORT_HANDLERS];                      // Indexed by P1IV / 2
+isr_handler uca0_handlers[UART_HANDLERS];                       // Indexed by UCA0IV / 2
+
+volatile unsigned int bench_end;                                // TA1R when the handler started
+unsigned int latency_min[NUMBER_OF_BENCHES];                    // Fewest cycles, vector entry to handler
+unsigned int latency_max[NUMBER_OF_BENCHES];                    // Most cycles, vector entry to handler
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char i;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable inputs and outputs
+
+    P1DIR = BIT0;                                               // P1.0 red LED is an output
+    P9DIR = BIT7;                                               // P9.7 green LED is an output
+    P1OUT = BIT1;                                               // Red LED off, pull-up for P1.1
+    P1REN = BIT1;
+    P9OUT = 0x00;                                               // Green LED off
+
+    select_clock_signals();                                     // MCLK = SMCLK = 8MHz
+    assign_pins_to_uart();                                      // P4.2 is for TXD, P4.3 is for RXD
+    use_9600_baud();                                            // UART operates at 9600 bits per second
+
+    for(i = 0; i < TIMER_A_HANDLERS; i = i + 1)                 // Nothing registered yet
+    {
+        timer0_a1_handlers[i] = no_handler;
+    }
+    for(i = 0; i < PORT_HANDLERS; i = i + 1)
+    {
+        port1_handlers[i] = no_handler;
+    }
+    for(i = 0; i < UART_HANDLERS; i = i + 1)
+    {
+        uca0_handlers[i] = no_handler;
+    }
+
+    run_benchmark();
+
+    // timer0_semi_atuo_pwm, but with both compare matches on the shared vector
+    register_handler(timer0_a1_handlers, TA0IV_TACCR1, red_led_on);
+    register_handler(timer0_a1_handlers, TA0IV_TAIFG, red_led_off);
+    TA0CCR0 = 50000;                                            // Period (count 0 --> 50K)
+    TA0CCR1 = 45000;                                            // Red LED on at 45K
+    TA0CCTL1 = CCIE;
+    TA0CTL = ACLK | UP | TACLR | TAIE;                          // TAIE - interrupt when count returns to 0
+
+    // red_green_p11_p12, S1 toggles the green LED
+    register_handler(port1_handlers, P1IV_P1IFG1, toggle_green_led);
+    P1IES = BIT1;                                               // HI --> LO transition
+    P1IFG = 0x00;                                               // No interrupts pending
+    P1IE = BIT1;
+
+    // uart_tx_rx_isr, the received byte is read in the handler
+    register_handler(uca0_handlers, UCIV__UCRXIFG, uart_received);
+    UCA0IE = UCRXIE;
+
+    _BIS_SR(LPM0_bits | GIE);                                   // Everything happens in the handlers
+    while(1);
+}
+
+// *********************************
+// Handler table functions
+// *********************************
+void no_handler(void)
+{
+}
+
+void register_handler(isr_handler *table, unsigned int iv_value, isr_handler handler)
+{
+    table[iv_value >> 1] = handler;                             // IV values are 0, 2, 4... so divide by 2
+}
+
+// *********************************
+// Application handlers
+// *********************************
+void red_led_on(void)
+{
+    P1OUT = P1OUT | BIT0;
+}
+
+void red_led_off(void)
+{
+    P1OUT = P1OUT & ~BIT0;
+}
+
+void toggle_green_led(void)
+{
+    P9OUT = P9OUT ^ BIT7;
+}
+
+void uart_received(void)
+{
+    if(UCA0RXBUF == 0x56)                                       // Reading UCA0RXBUF clears UCRXIFG too
+    {
+        P1OUT = P1OUT | BIT0;
+    }
+    else
+    {
+        P1OUT = P1OUT & ~BIT0;
+    }
+}
+
+// *********************************
+// Benchmark
+// *********************************
+void bench_stamp(void)
+{
+    bench_end = TA1R;                                           // First thing the handler does
+}
+
+void bench_trigger(unsigned char bench)
+{
+    if(bench == BENCH_TIMER)
+    {
+        TA0CCTL1 = TA0CCTL1 | CCIFG;                            // Pretend TA0R reached TA0CCR1
+    }
+    else if(bench == BENCH_PORT)
+    {
+        P1IFG = P1IFG | BIT1;                                   // Pretend S1 was pushed
+    }
+    else
+    {
+        UCA0IFG = UCA0IFG | UCSTTIFG;                           // Pretend a start bit arrived
+    }
+}
+
+void run_benchmark(void)
+{
+    unsigned char bench;
+    unsigned char trial;
+    unsigned int start;
+    unsigned int cycles;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;                        // 1 count = 1 CPU cycle at 8MHz
+
+    register_handler(timer0_a1_handlers, TA0IV_TACCR1, bench_stamp);
+    register_handler(port1_handlers, P1IV_P1IFG1, bench_stamp);
+    register_handler(uca0_handlers, UCIV__UCSTTIFG, bench_stamp);
+
+    TA0CCTL1 = CCIE;                                            // Timer stopped, flag is set by software
+    P1IFG = 0x00;
+    P1IE = BIT1;
+    UCA0IE = UCSTTIE;
+
+    for(bench = 0; bench < NUMBER_OF_BENCHES; bench = bench + 1)
+    {
+        latency_min[bench] = 0xFFFF;
+        latency_max[bench] = 0;
+
+        for(trial = 0; trial < BENCH_TRIALS; trial = trial + 1)
+        {
+            start = TA1R;
+            _BIS_SR(GIE);
+            bench_trigger(bench);                               // Interrupt is taken straight away
+            _BIC_SR(GIE);
+
+            cycles = bench_end - start;
+            if(cycles < latency_min[bench]) latency_min[bench] = cycles;
+            if(cycles > latency_max[bench]) latency_max[bench] = cycles;
+        }
+    }
+
+    TA0CCTL1 = 0;                                               // Put everything back
+    P1IE = 0x00;
+    UCA0IE = 0x00;
+    TA1CTL = 0;
+    register_handler(timer0_a1_handlers, TA0IV_TACCR1, no_handler);
+    register_handler(port1_handlers, P1IV_P1IFG1, no_handler);
+    register_handler(uca0_handlers, UCIV__UCSTTIFG, no_handler);
+}
+
+// ******************************************************
+// Shared vector ISRs - read the IV register once, then
+// jump straight to the registered handler
+// ******************************************************
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt void Timer0_A1_ISR(void)
+{
+    timer0_a1_handlers[__even_in_range(TA0IV, TA0IV_TAIFG) >> 1]();
+}
+
+#pragma vector=PORT1_VECTOR
+__interrupt void Port_1(void)
+{
+    port1_handlers[__even_in_range(P1IV, P1IV_P1IFG7) >> 1]();
+}
+
+#pragma vector=USCI_A0_VECTOR
+__interrupt void UART_ISR(void)
+{
+    uca0_handlers[__even_in_range(UCA0IV, UCIV__UCTXCPTIFG) >> 1]();
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
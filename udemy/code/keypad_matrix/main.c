@@ -0,0 +1,479 @@
+/*
+ * A 4 x 4 keypad that sleeps in LPM4 until a key is pressed
+ *
+ * push_button and red_green_p11_p12 give each button its own pin. 16 keys would need 16
+ * pins, so keypads are wired as a MATRIX instead - 4 row wires and 4 column wires, and
+ * each key joins one row to one column:
+ *
+ *      rows    P3.0 - P3.3     inputs with pull-up resistors, interrupt on a falling edge
+ *      columns P2.0 - P2.3     outputs
+ *
+ *      key number = column * 4 + row   (0 to 15)
+ *
+ * WAITING
+ * -------
+ * All the columns are driven LO. No key pressed - every row is pulled HI. Any key pulls
+ * its row LO, and the port interrupt wakes us. Nothing else runs, so we wait in LPM4.
+ *
+ * SCANNING
+ * --------
+ * The port ISR turns the row interrupts off and starts Timer0 (ACLK, every SCAN_TICKS).
+ * Each scan drives ONE column LO (the others are inputs, so they do not fight) and reads
+ * which rows are LO - the keys pressed in that column. The 16 answers make one 16-bit
+ * "raw" bitmap.
+ *
+ * Contacts bounce, so a key only counts as pressed when it has been pressed in the last
+ * DEBOUNCE_SCANS raw bitmaps, and as released when it has been released in all of them.
+ * Every key that changes puts an event in the event queue for main(). Any number of
+ * keys can be held at once (n-key rollover). When everything has been released the
+ * columns are driven LO again, the row interrupts go back on, and we go back to LPM4.
+ *
+ * GHOST KEYS
+ * ----------
+ * Without a diode on each key, three keys at the corners of a rectangle make the fourth
+ * corner look pressed too. Two columns that share two or more rows could be a ghost,
+ * so those scans are thrown away (ghost_scans counts them) until a key is let go.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * First the keypad is SIMULATED: script[] "presses" keys at set times (Timer1, ACLK).
+ * It sets P3IFG to make the port interrupt itself, and the scan reads sim_keys - with
+ * BOUNCE_SCANS scans of bouncing after every change - instead of the pins. The events
+ * must match expected_events[] (event_errors counts the ones that do not).
+ *
+ *  - scan_cycles_worst / scan_cycles_average - CPU cycles of one scan (Timer2, SMCLK)
+ *  - latency_worst_us - from a key changing to its event being in the queue
+ *
+ * Green LED - passed. Then the real keypad is used: key 0 toggles the red LED, key 1
+ * toggles the green LED.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+
+#define ROWS                    (BIT3 | BIT2 | BIT1 | BIT0) // P3
+#define COLUMNS                 (BIT3 | BIT2 | BIT1 | BIT0) // P2
+#define NUMBER_OF_COLUMNS       4
+#define SCAN_TICKS              200                 // 200 * 25us = 5ms
+#define DEBOUNCE_SCANS          4                   // Must be a power of 2
+#define EVENT_QUEUE_SIZE        16                  // Must be a power of 2
+#define KEY_PRESSED             0x80                // In an event, with the key number
+
+#define SCRIPT_STEPS            9
+#define EXPECTED_EVENTS         10
+#define BOUNCE_SCANS            2
+#define SCRIPT_END_TICKS        30000               // 750ms
+
+struct script_step
+{
+    unsigned int time;                              // Timer1 ticks from the start
+    unsigned int keys;                              // Held from then on
+};
+
+const struct script_step script[SCRIPT_STEPS] =
+{
+    {  400, 0x0020},                                // Key 5 down
+    { 2000, 0x0420},                                // Key 10 down too - rollover
+    { 4000, 0x0400},                                // Key 5 up
+    { 6000, 0x0000},                                // Key 10 up
+    {10000, 0x0007},                                // Keys 0, 1, 2 at once (one column)
+    {14000, 0x0000},
+    {18000, 0x0033},                                // Keys 0, 1, 4, 5 - a rectangle, could be a ghost
+    {22000, 0x0000},
+    {SCRIPT_END_TICKS, 0x0000}                      // End
+};
+
+const unsigned char expected_events[EXPECTED_EVENTS] =
+{
+    5 | KEY_PRESSED, 10 | KEY_PRESSED, 5, 10,
+    0 | KEY_PRESSED, 1 | KEY_PRESSED, 2 | KEY_PRESSED, 0, 1, 2
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void keypad_init(void);
+void keypad_idle(void);                             // Columns LO, row interrupts on
+unsigned char read_column(unsigned char column);    // Rows pressed in one column
+unsigned char get_event(unsigned char *event);      // 0 - queue empty
+void run_simulation(void);
+
+unsigned int history[DEBOUNCE_SCANS];               // Last raw bitmaps
+unsigned char history_index;
+unsigned int debounced;                             // Keys held, after debouncing
+volatile unsigned char scanning;
+
+unsigned char event_queue[EVENT_QUEUE_SIZE];
+volatile unsigned char event_head;                  // Written by the scan ISR
+volatile unsigned char event_tail;                  // Written by main()
+unsigned int events_lost;
+unsigned int ghost_scans;
+
+unsigned char simulated;                            // 1 - read sim_keys, not the pins
+volatile unsigned int sim_keys;
+unsigned int sim_old_keys;
+volatile unsigned char sim_bounce;                  // Scans left of bouncing
+volatile unsigned int sim_change_time;              // Timer1 when the script changed the keys
+unsigned char script_step;
+
+unsigned char event_errors;
+unsigned int scan_cycles_worst;
+unsigned long scan_cycles_total;
+unsigned int scans;
+unsigned int scan_cycles_average;
+unsigned int latency_worst_ticks;
+unsigned long latency_worst_us;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char event;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    TA2CTL = SMCLK | CONTINUOUS | TACLR;            // Counts CPU cycles (only runs when awake)
+    keypad_init();
+
+    run_simulation();
+    if(event_errors == 0)
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+
+    while(1)
+    {
+        _BIC_SR(GIE);                               // No lost wake-up between test and sleep
+        if(event_head == event_tail)
+        {
+            if(scanning)
+            {
+                _BIS_SR(LPM3_bits | GIE);           // Timer0 needs ACLK
+            }
+            else
+            {
+                _BIS_SR(LPM4_bits | GIE);           // Only a key can wake us
+            }
+        }
+        _BIS_SR(GIE);
+
+        while(get_event(&event))
+        {
+            if(event == (0 | KEY_PRESSED))
+            {
+                P1OUT = P1OUT ^ BIT0;
+            }
+            if(event == (1 | KEY_PRESSED))
+            {
+                P9OUT = P9OUT ^ BIT7;
+            }
+        }
+    }
+}
+
+// ******************************
+// Keypad driver
+// ******************************
+void keypad_init(void)
+{
+    P3DIR = P3DIR & ~ROWS;                          // Rows are inputs...
+    P3REN = P3REN | ROWS;
+    P3OUT = P3OUT | ROWS;                           // ...with pull-ups
+    P3IES = P3IES | ROWS;                           // HI to LO - a key pressed
+
+    P2OUT = P2OUT & ~COLUMNS;
+    keypad_idle();
+}
+
+void keypad_idle(void)
+{
+    unsigned char i;
+
+    TA0CTL = 0;                                     // No more scans
+    TA0CCTL0 = 0;
+    scanning = 0;
+    for(i = 0; i < DEBOUNCE_SCANS; i = i + 1)
+    {
+        history[i] = 0;
+    }
+
+    P2DIR = P2DIR | COLUMNS;                        // Every column LO
+    __delay_cycles(10);                             // Let the rows settle
+    P3IFG = P3IFG & ~ROWS;
+    P3IE = P3IE | ROWS;
+
+    if(simulated ? sim_keys : (~P3IN & ROWS))       // Still held (a ghost, or bouncing) - no
+    {                                               // edge will come, so make one
+        P3IFG = P3IFG | BIT0;
+    }
+}
+
+unsigned char read_column(unsigned char column)
+{
+    unsigned char rows;
+    unsigned int bit;
+
+    if(simulated)
+    {
+        bit = sim_keys;
+        if(sim_bounce & 1)                          // Bouncing - the old keys on odd scans
+        {
+            bit = sim_old_keys;
+        }
+        return (bit >> (column * 4)) & 0x0F;
+    }
+
+    P2DIR = (P2DIR & ~COLUMNS) | (BIT0 << column);  // Only this column is driven LO
+    __delay_cycles(10);
+    rows = ~P3IN & ROWS;                            // LO - pressed
+    P2DIR = P2DIR & ~COLUMNS;
+    return rows;
+}
+
+unsigned char get_event(unsigned char *event)
+{
+    if(event_tail == event_head)
+    {
+        return 0;
+    }
+    *event = event_queue[event_tail];
+    event_tail = (event_tail + 1) & (EVENT_QUEUE_SIZE - 1);
+    return 1;
+}
+
+// ****************************************************
+// Port 3 ISR - a row went LO, start scanning
+// ****************************************************
+#pragma vector=PORT3_VECTOR
+__interrupt void Row_ISR(void)
+{
+    P3IE = P3IE & ~ROWS;                            // Timer0 takes over
+    P3IFG = P3IFG & ~ROWS;
+    P2DIR = P2DIR & ~COLUMNS;
+
+    scanning = 1;
+    TA0CCR0 = SCAN_TICKS;
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+    __bic_SR_register_on_exit(LPM4_bits);           // main() must sleep in LPM3 now, not LPM4
+}
+
+// ****************************************************
+// Timer0 ISR - one scan, debounce, events
+// ****************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Scan_ISR(void)
+{
+    unsigned int start = TA2R;
+    unsigned int raw = 0;
+    unsigned int all_on = 0xFFFF;
+    unsigned int any_on = 0;
+    unsigned int changed;
+    unsigned int latency;
+    unsigned char rows[NUMBER_OF_COLUMNS];
+    unsigned char column;
+    unsigned char other;
+    unsigned char common;
+    unsigned char key;
+    unsigned char next;
+    unsigned char ghost = 0;
+    unsigned char i;
+
+    for(column = 0; column < NUMBER_OF_COLUMNS; column = column + 1)
+    {
+        rows[column] = read_column(column);
+        raw = raw | ((unsigned int)rows[column] << (column * 4));
+    }
+    if(sim_bounce)
+    {
+        sim_bounce = sim_bounce - 1;
+    }
+
+    for(column = 0; column < NUMBER_OF_COLUMNS; column = column + 1)
+    {
+        for(other = column + 1; other < NUMBER_OF_COLUMNS; other = other + 1)
+        {
+            common = rows[column] & rows[other];
+            if(common & (common - 1))               // Two or more rows in both
+            {
+                ghost = 1;
+            }
+        }
+    }
+
+    if(ghost)
+    {
+        ghost_scans = ghost_scans + 1;
+        history[history_index] = debounced;         // Changes nothing
+    }
+    else
+    {
+        history[history_index] = raw;
+    }
+    history_index = (history_index + 1) & (DEBOUNCE_SCANS - 1);
+
+    for(i = 0; i < DEBOUNCE_SCANS; i = i + 1)
+    {
+        all_on = all_on & history[i];
+        any_on = any_on | history[i];
+    }
+    changed = debounced ^ ((debounced | all_on) & any_on); // On in all, or off in all
+    debounced = debounced ^ changed;
+
+    for(key = 0; changed; key = key + 1)            // One event for each change
+    {
+        if(changed & 1)
+        {
+            next = (event_head + 1) & (EVENT_QUEUE_SIZE - 1);
+            if(next == event_tail)
+            {
+                events_lost = events_lost + 1;
+            }
+            else
+            {
+                event_queue[event_head] = key | (((debounced >> key) & 1) ? KEY_PRESSED : 0);
+                event_head = next;
+            }
+            if(simulated)
+            {
+                latency = TA1R - sim_change_time;
+                if(latency > latency_worst_ticks)
+                {
+                    latency_worst_ticks = latency;
+                }
+            }
+        }
+        changed = changed >> 1;
+    }
+
+    if((debounced == 0) && (raw == 0) && (any_on == 0))
+    {
+        keypad_idle();                              // Everything let go
+    }
+
+    start = TA2R - start;
+    if(start > scan_cycles_worst)
+    {
+        scan_cycles_worst = start;
+    }
+    scan_cycles_total = scan_cycles_total + start;
+    scans = scans + 1;
+
+    __bic_SR_register_on_exit(LPM4_bits);           // Wake up main() for the events
+}
+
+// ****************************************************
+// Self test - a scripted keypad
+// ****************************************************
+void run_simulation(void)
+{
+    unsigned char count = 0;
+    unsigned char event;
+
+    simulated = 1;
+    script_step = 0;
+    sim_keys = 0;
+
+    TA1CCR1 = script[0].time;
+    TA1CTL = ACLK | CONTINUOUS | TACLR;             // The script's clock
+    TA1CCTL1 = CCIE;
+
+    while(script_step < SCRIPT_STEPS)
+    {
+        _BIC_SR(GIE);
+        if(event_head == event_tail)
+        {
+            _BIS_SR(LPM3_bits | GIE);               // Never LPM4 here - Timer1 needs ACLK
+        }
+        _BIS_SR(GIE);
+
+        while(get_event(&event))
+        {
+            if((count < EXPECTED_EVENTS) && (event != expected_events[count]))
+            {
+                event_errors = event_errors + 1;
+            }
+            count = count + 1;
+        }
+    }
+    if(count != EXPECTED_EVENTS)
+    {
+        event_errors = event_errors + 1;
+    }
+    if((ghost_scans == 0) || events_lost)
+    {
+        event_errors = event_errors + 1;
+    }
+
+    _BIC_SR(GIE);
+    TA1CTL = 0;
+    TA1CCTL1 = 0;
+    simulated = 0;
+    keypad_idle();
+    _BIS_SR(GIE);
+
+    if(scans)
+    {
+        scan_cycles_average = scan_cycles_total / scans;
+    }
+    latency_worst_us = (unsigned long)latency_worst_ticks * 25;
+}
+
+// ****************************************************
+// Timer1 ISR - the next script step (self test only)
+// ****************************************************
+#pragma vector=TIMER1_A1_VECTOR
+__interrupt void Script_ISR(void)
+{
+    switch(__even_in_range(TA1IV, TA1IV_TAIFG))
+    {
+        case TA1IV_TACCR1:
+        {
+            sim_old_keys = sim_keys;
+            sim_keys = script[script_step].keys;
+            sim_bounce = BOUNCE_SCANS;
+            sim_change_time = TA1R;
+            script_step = script_step + 1;
+            if(script_step < SCRIPT_STEPS)
+            {
+                TA1CCR1 = script[script_step].time;
+            }
+            else
+            {
+                TA1CCTL1 = 0;                       // The end
+            }
+
+            if(!scanning && sim_keys)               // A key "pressed" while asleep -
+            {
+                P3IFG = P3IFG | BIT0;               // the port interrupt, made by us
+            }
+            __bic_SR_register_on_exit(LPM4_bits);
+            break;
+        }
+    }
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
@@ -0,0 +1,395 @@
+/*
+ * Showing numbers on the LaunchPad's LCD with the LCD_C module
+ *
+ * loop_nested_challenge works out a five digit odometer in km, but the only way to see
+ * it is in the debugger. The LaunchPad has a 6 character LCD, and the LCD_C module can
+ * drive it all by itself: we write which segments should be on into the LCD memory
+ * registers (LCDM1 to LCDM20), and LCD_C keeps refreshing the glass from ACLK. No CPU
+ * time is needed to keep the display on, so it stays on in LPM3.
+ *
+ * DIGITS AND SEGMENTS
+ * -------------------
+ * Each character position uses two LCD memory bytes. digit_segments[] says which bits to
+ * set for each digit (the glass wiring is fixed, so this is a const table worked out
+ * before the program runs), and digit_position[] says which two bytes belong to each of
+ * the 6 positions (position 0 is on the left).
+ *
+ * DOUBLE BUFFERING
+ * ----------------
+ * LCD_C has a second set of memory registers, the "blink memory" LCDBM1 to LCDBM20.
+ * LCDDISP in LCDCMEMCTL picks which set is on the glass. If we changed the memory that
+ * is on the glass, the LCD could show a half-changed digit for one frame. So we always
+ * write the set that is NOT on the glass and then flip LCDDISP.
+ *
+ * shown[][] remembers what is in each set, so only digits that are different from what
+ * is already there are written.
+ *
+ * BLINKING
+ * --------
+ * lcd_blink() makes the whole display blink (LCDBLKMOD_10) without any more CPU time.
+ * In that mode LCD_C always shows LCDMx: it clears LCDDISP and software can not set it.
+ * So lcd_blink() first copies what is on the glass into LCDMx, and while blinking
+ * lcd_show() writes LCDMx directly instead of flipping. LCDBMx is left alone, so shown[1]
+ * is still right when the blinking stops and double buffering starts again.
+ *
+ * ACLK must come from the 32768Hz crystal for a steady refresh, so this program uses
+ * CSCTL2 = 0x0033 instead of 0x0133, and ONE_SECOND is 32768 counts.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * lcd_decode() reads the two bytes of a position from the memory on the glass and looks
+ * them up in digit_segments[] to get the character back. decode_ok is 1 if every number
+ * in test_numbers[] decoded back correctly - double buffered, then blinking (starting
+ * with LCDBMx on the glass, so the copy into LCDMx is checked too), then double buffered
+ * again after the blinking stops. Timer1 (1 count = 1 cycle at 8MHz) times an
+ * update where only the last digit changes (cycles_one_digit) and one where all of them
+ * change (cycles_all_digits).
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define ONE_SECOND              32768               // ACLK is the 32768Hz crystal here
+
+#define LCD_POSITIONS           6                   // Characters on the glass
+#define LCD_BLANK               10                  // Character codes after the digits
+#define LCD_MINUS               11
+#define LCD_CHARACTERS          12
+#define LCD_UNKNOWN             0xFF                // lcd_decode() could not match it
+#define NUMBER_OF_TESTS         4
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals, ACLK = crystal
+void start_crystal(void);                           // 32768Hz LFXT on PJ.4 / PJ.5
+void lcd_init(void);                                // Segment pins, charge pump, ACLK refresh
+void lcd_show(const unsigned char *characters);     // LCD_POSITIONS character codes
+void lcd_write(unsigned char set, const unsigned char *characters); // 0 - LCDMx, 1 - LCDBMx
+void lcd_show_number(long value);                   // Right aligned, blanks on the left
+void lcd_blink(unsigned char on);
+unsigned char lcd_decode(unsigned char position);   // Character on the glass at position
+unsigned char decode_numbers(void);                 // 1 - every test number decodes back
+
+// Bits in the two memory bytes for each character (segments a to f, g and m, k and q)
+const unsigned char digit_segments[LCD_CHARACTERS][2] =
+{
+    {0xFC, 0x28},                                   // 0
+    {0x60, 0x20},                                   // 1
+    {0xDB, 0x00},                                   // 2
+    {0xF3, 0x00},                                   // 3
+    {0x67, 0x00},                                   // 4
+    {0xB7, 0x00},                                   // 5
+    {0xBF, 0x00},                                   // 6
+    {0xE4, 0x00},                                   // 7
+    {0xFF, 0x00},                                   // 8
+    {0xF7, 0x00},                                   // 9
+    {0x00, 0x00},                                   // LCD_BLANK
+    {0x03, 0x00}                                    // LCD_MINUS
+};
+
+// First of the two memory bytes for each position (0 = LCDM1)
+const unsigned char digit_position[LCD_POSITIONS] = {9, 5, 3, 18, 14, 7};
+
+const long test_numbers[NUMBER_OF_TESTS] = {0, 7, 99999, -12345};
+const unsigned char test_expected[NUMBER_OF_TESTS][LCD_POSITIONS] =
+{
+    {LCD_BLANK, LCD_BLANK, LCD_BLANK, LCD_BLANK, LCD_BLANK, 0},
+    {LCD_BLANK, LCD_BLANK, LCD_BLANK, LCD_BLANK, LCD_BLANK, 7},
+    {LCD_BLANK, 9, 9, 9, 9, 9},
+    {LCD_MINUS, 1, 2, 3, 4, 5}
+};
+
+unsigned char shown[2][LCD_POSITIONS];              // [0] LCDMx, [1] LCDBMx - what is in each
+unsigned char on_glass;                             // 0 or 1, same as LCDDISP
+unsigned char blinking;                             // LCDDISP held at 0 - no flipping
+
+volatile unsigned long km;                          // The odometer
+volatile unsigned char km_changed;
+
+unsigned char decode_ok;
+unsigned int cycles_one_digit;
+unsigned int cycles_all_digits;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned int start;
+    unsigned char p;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PJSEL0 = BIT4 | BIT5;                           // PJ.4 and PJ.5 are for the crystal
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    start_crystal();
+    select_clock_signals();
+    lcd_init();
+
+    // Self test - does what is on the glass decode back to the number?
+    decode_ok = decode_numbers();                   // Double buffered
+
+    lcd_show_number(test_numbers[0]);               // LCDBMx on the glass...
+    lcd_blink(1);                                   // ...so this must copy it to LCDMx
+    for(p = 0; p < LCD_POSITIONS; p = p + 1)
+    {
+        if(lcd_decode(p) != test_expected[0][p])
+        {
+            decode_ok = 0;
+        }
+    }
+    if(LCDCMEMCTL & LCDDISP)
+    {
+        decode_ok = 0;
+    }
+    decode_ok = decode_ok & decode_numbers();       // Blinking - straight into LCDMx
+    lcd_blink(0);
+    decode_ok = decode_ok & decode_numbers();       // Double buffered again
+
+    // Benchmark
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+    lcd_show_number(100000);
+    lcd_show_number(100000);                        // Both sets hold 100000 now
+    start = TA1R;
+    lcd_show_number(100001);                        // One digit different
+    cycles_one_digit = TA1R - start;
+    lcd_show_number(222222);
+    lcd_show_number(222222);
+    start = TA1R;
+    lcd_show_number(333333);                        // Every digit different
+    cycles_all_digits = TA1R - start;
+    TA1CTL = 0;
+
+    // The odometer - one km every second
+    km = 0;
+    lcd_show_number(km);
+    TA0CCR0 = ONE_SECOND - 1;
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+
+    while(1)
+    {
+        _BIS_SR(LPM3_bits | GIE);                   // The LCD keeps going in LPM3
+        if(km_changed)
+        {
+            km_changed = 0;
+            lcd_show_number(km);
+        }
+    }
+}
+
+// ******************************
+// LCD driver
+// ******************************
+void lcd_init(void)
+{
+    unsigned char p;
+
+    LCDCPCTL0 = 0xFFFF;                             // Segment pins L0 to L15...
+    LCDCPCTL1 = 0xFC3F;                             // ...L16 to L21 and L26 to L31...
+    LCDCPCTL2 = 0x0FFF;                             // ...and L32 to L43 go to the glass
+
+    LCDCCTL0 = LCDDIV_1 | LCDPRE__16 | LCD4MUX | LCDLP; // ACLK / 16, 4 commons, low power
+    LCDCVCTL = VLCD_1 | VLCDREF_0 | LCDCPEN;        // Charge pump makes 2.6V for the glass
+    LCDCCPCTL = LCDCPCLKSYNC;
+    LCDCMEMCTL = LCDCLRM | LCDCLRBM;                // Both memory sets empty
+    LCDCCTL0 = LCDCCTL0 | LCDON;
+
+    for(p = 0; p < LCD_POSITIONS; p = p + 1)
+    {
+        shown[0][p] = LCD_BLANK;
+        shown[1][p] = LCD_BLANK;
+    }
+    on_glass = 0;                                   // LCDDISP = 0, LCDMx on the glass
+    blinking = 0;
+}
+
+void lcd_write(unsigned char set, const unsigned char *characters)
+{
+    unsigned char *memory;
+    unsigned char p;
+    unsigned char c;
+
+    if(set)
+    {
+        memory = (unsigned char *)&LCDBM1;
+    }
+    else
+    {
+        memory = (unsigned char *)&LCDM1;
+    }
+
+    for(p = 0; p < LCD_POSITIONS; p = p + 1)
+    {
+        c = characters[p];
+        if(c != shown[set][p])                      // Only write what is different
+        {
+            memory[digit_position[p]] = digit_segments[c][0];
+            memory[digit_position[p] + 1] = digit_segments[c][1];
+            shown[set][p] = c;
+        }
+    }
+}
+
+void lcd_show(const unsigned char *characters)
+{
+    unsigned char hidden = on_glass ^ 1;
+
+    if(blinking)                                    // LCDMx is always on the glass
+    {
+        lcd_write(0, characters);
+        return;
+    }
+
+    lcd_write(hidden, characters);
+
+    if(hidden)                                      // Flip - the new one goes on the glass
+    {
+        LCDCMEMCTL = LCDCMEMCTL | LCDDISP;
+    }
+    else
+    {
+        LCDCMEMCTL = LCDCMEMCTL & ~LCDDISP;
+    }
+    on_glass = hidden;
+}
+
+void lcd_show_number(long value)
+{
+    unsigned char characters[LCD_POSITIONS];
+    unsigned char negative = 0;
+    unsigned char p = LCD_POSITIONS;
+
+    if(value < 0)
+    {
+        negative = 1;
+        value = -value;
+    }
+
+    do                                              // Digits from the right
+    {
+        p = p - 1;
+        characters[p] = value % 10;
+        value = value / 10;
+    } while((value != 0) && (p > 0));
+
+    if(negative && (p > 0))
+    {
+        p = p - 1;
+        characters[p] = LCD_MINUS;
+    }
+    while(p > 0)
+    {
+        p = p - 1;
+        characters[p] = LCD_BLANK;
+    }
+
+    lcd_show(characters);
+}
+
+void lcd_blink(unsigned char on)
+{
+    if(on)
+    {
+        if(on_glass)                                // LCDMx is about to go on the glass...
+        {
+            lcd_write(0, shown[1]);                 // ...so give it what is there now
+            LCDCMEMCTL = LCDCMEMCTL & ~LCDDISP;
+            on_glass = 0;
+        }
+        LCDCBLKCTL = LCDBLKDIV_7 | LCDBLKPRE_2 | LCDBLKMOD_2; // Whole display, about once a second
+        blinking = 1;
+    }
+    else
+    {
+        LCDCBLKCTL = 0;                             // LCDDISP is still 0 - double buffering again
+        blinking = 0;
+    }
+}
+
+unsigned char lcd_decode(unsigned char position)
+{
+    const unsigned char *memory;
+    unsigned char c;
+
+    if(LCDCMEMCTL & LCDDISP)                        // Read whichever set is on the glass
+    {
+        memory = (const unsigned char *)&LCDBM1;
+    }
+    else
+    {
+        memory = (const unsigned char *)&LCDM1;
+    }
+
+    for(c = 0; c < LCD_CHARACTERS; c = c + 1)
+    {
+        if((memory[digit_position[position]] == digit_segments[c][0]) &&
+           (memory[digit_position[position] + 1] == digit_segments[c][1]))
+        {
+            return c;
+        }
+    }
+    return LCD_UNKNOWN;
+}
+
+unsigned char decode_numbers(void)
+{
+    unsigned char ok = 1;
+    unsigned char i;
+    unsigned char p;
+
+    for(i = 0; i < NUMBER_OF_TESTS; i = i + 1)
+    {
+        lcd_show_number(test_numbers[i]);
+        for(p = 0; p < LCD_POSITIONS; p = p + 1)
+        {
+            if(lcd_decode(p) != test_expected[i][p])
+            {
+                ok = 0;
+            }
+        }
+    }
+    return ok;
+}
+
+// ******************************
+// Timer0 ISR - one km a second
+// ******************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    km = km + 1;
+    if(km == 100000)                                // Odometer rolls over from 99999
+    {
+        km = 0;
+    }
+    km_changed = 1;
+    __bic_SR_register_on_exit(LPM3_bits);           // Wake up main()
+}
+
+// *********************
+// Functions
+// *********************
+void start_crystal(void)
+{
+    CSCTL0 = 0xA500;                                // "Password" to access clock registers
+    CSCTL4 = CSCTL4 & ~LFXTOFF;                     // Turn on the 32768Hz crystal
+    do
+    {
+        CSCTL5 = CSCTL5 & ~LFXTOFFG;                // Clear the crystal fault flag...
+        SFRIFG1 = SFRIFG1 & ~OFIFG;
+    } while(SFRIFG1 & OFIFG);                       // ...until the crystal has started
+}
+
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0033;                    // Assigns additional clock signals (ACLK = crystal)
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
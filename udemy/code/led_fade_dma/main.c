@@ -0,0 +1,393 @@
+/*
+ * Gamma-corrected LED fades with PWM, pushed by DMA
+ *
+ * timer0_auto_pwm lets Timer0 switch the red LED by itself with a fixed duty cycle. To
+ * FADE the LED the duty cycle (TA0CCR1) has to change a little every PWM period. Doing
+ * that in an ISR means waking the CPU 250 times a second. Here the DMA does it instead:
+ *
+ *  - Timer0 counts SMCLK / 8 = 1MHz in UP mode, PWM_PERIOD counts = 4ms (250Hz), and
+ *    drives P1.0 (TA0.1) with OUTMOD_7, HI from 0 until TA0CCR1
+ *  - A fade is worked out ONCE into ramp[], one TA0CCR1 value for every PWM period
+ *  - Every time Timer0 gets to TA0CCR0 (DMA trigger 1), DMA channel 0 copies the next
+ *    word of ramp[] into TA0CCR1, right at the start of the new period
+ *  - At the end of the ramp the DMA ISR runs once. The CPU sleeps in LPM0 the whole time.
+ *
+ * GAMMA
+ * -----
+ * Our eyes do not see brightness in a straight line - 50% duty looks much brighter than
+ * "half way". gamma_table[] turns a brightness LEVEL (0 to 255, looks evenly spaced) into
+ * a duty count (0 to PWM_PERIOD):
+ *
+ *      gamma_table[level] = PWM_PERIOD * (level / 255) ^ 2.2
+ *
+ * It is worked out before compiling, so it is const and lives in FRAM.
+ *
+ * FADES
+ * -----
+ *  - FADE_LINEAR        the level changes by the same amount every period
+ *  - FADE_EXPONENTIAL   the level moves 1 / 2^EXP_SHIFT of the way that is LEFT every
+ *                       period - fast at first, then slowing down, like an RC circuit
+ *
+ * fade_start() plays a ramp once (DMAIE, the ISR sets fade_done). fade_repeat() uses
+ * DMADT_4 (repeated single transfer) - the DMA goes back to the start of the ramp by
+ * itself, so a "breathing" LED (up then down, forever) needs no interrupts at all.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ *  - ramp_errors counts ramps that go the wrong way or do not end on the right duty
+ *  - The first fade up is done the old way: a Timer0 ISR every period writes TA0CCR1.
+ *    Timer1 (1 count = 1 cycle at 8MHz) adds up the time spent in it for one second of
+ *    fading into isr_cycles_per_second (plus the few cycles to get in and out of every
+ *    ISR, which the timer can not see).
+ *  - Then an exponential fade down and the same fade up are done with the DMA. Each DMA
+ *    transfer holds the CPU for a few cycles, which no timer can see, so it is measured
+ *    the other way round: count_loops() spins a counting loop (interrupts off) for
+ *    LOOP_OVERFLOWS roll-overs of Timer1 - about one second - once with nothing else
+ *    going on (loops_idle) and once while the DMA plays the fade up (loops_with_dma).
+ *    Timer1 sets the window, so the loop never touches TA0CCR0 CCIFG, the DMA's
+ *    trigger. The loops that went missing are the cycles the DMA took:
+ *
+ *      dma_cycles_per_second = (loops_idle - loops_with_dma) * CPU_HZ / loops_idle
+ *                              + the one DMA ISR at the end (dma_isr_cycles)
+ *
+ *    build_cycles is the one-off cost of fade_build().
+ *  - After that the LED breathes for ever. The green LED is on if ramp_errors is 0.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+
+#define PWM_PERIOD              4000                // 1MHz / 4000 = 250Hz
+#define PWM_HZ                  250                 // Duty updates every second
+#define LEVELS                  256                 // Brightness 0 to 255
+#define MAX_LEVEL               (LEVELS - 1)
+#define FADE_STEPS              250                 // 1 second
+#define MAX_RAMP                (2 * FADE_STEPS)    // Up and down, for breathing
+#define EXP_SHIFT               4                   // Exponential - 1/16 of what is left
+#define CPU_HZ                  8000000UL           // MCLK after select_clock_signals()
+#define LOOP_OVERFLOWS          122                 // 122 * 65536 cycles = 0.9994 seconds
+
+#define FADE_LINEAR             0
+#define FADE_EXPONENTIAL        1
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void pwm_init(void);                                // Timer0 and P1.0
+void fade_build(unsigned int *ramp, unsigned int steps,
+                unsigned char from, unsigned char to, unsigned char shape);
+void fade_start(unsigned int *ramp, unsigned int steps); // Once, then the DMA ISR
+void fade_repeat(unsigned int *ramp, unsigned int steps); // For ever, no ISR
+void fade_wait(void);
+void check_ramp(unsigned int *ramp, unsigned int steps, unsigned char from, unsigned char to);
+void isr_fade(unsigned int *ramp, unsigned int steps); // The old way, for the benchmark
+unsigned long count_loops(unsigned int *ramp);      // Loops in LOOP_OVERFLOWS, 0 - no fade
+
+// gamma_table[level] = PWM_PERIOD * (level / 255) ^ 2.2
+const unsigned int gamma_table[LEVELS] =
+{
+       0,    0,    0,    0,    0,    1,    1,    1,    2,    3,    3,    4,    5,    6,    7,    8,
+       9,   10,   12,   13,   15,   16,   18,   20,   22,   24,   26,   29,   31,   33,   36,   39,
+      42,   45,   48,   51,   54,   57,   61,   64,   68,   72,   76,   80,   84,   88,   92,   97,
+     101,  106,  111,  116,  121,  126,  132,  137,  142,  148,  154,  160,  166,  172,  178,  185,
+     191,  198,  204,  211,  218,  225,  233,  240,  248,  255,  263,  271,  279,  287,  295,  304,
+     312,  321,  330,  339,  348,  357,  366,  376,  385,  395,  405,  415,  425,  435,  445,  456,
+     466,  477,  488,  499,  510,  521,  533,  544,  556,  568,  580,  592,  604,  617,  629,  642,
+     655,  667,  681,  694,  707,  721,  734,  748,  762,  776,  790,  804,  819,  833,  848,  863,
+     878,  893,  909,  924,  940,  955,  971,  987, 1003, 1020, 1036, 1053, 1069, 1086, 1103, 1120,
+    1138, 1155, 1173, 1191, 1209, 1227, 1245, 1263, 1282, 1300, 1319, 1338, 1357, 1376, 1395, 1415,
+    1435, 1454, 1474, 1494, 1515, 1535, 1556, 1576, 1597, 1618, 1639, 1661, 1682, 1704, 1725, 1747,
+    1769, 1791, 1814, 1836, 1859, 1882, 1905, 1928, 1951, 1974, 1998, 2022, 2046, 2070, 2094, 2118,
+    2143, 2167, 2192, 2217, 2242, 2267, 2293, 2318, 2344, 2370, 2396, 2422, 2448, 2475, 2501, 2528,
+    2555, 2582, 2609, 2637, 2664, 2692, 2720, 2748, 2776, 2805, 2833, 2862, 2891, 2920, 2949, 2978,
+    3008, 3037, 3067, 3097, 3127, 3157, 3188, 3218, 3249, 3280, 3311, 3342, 3373, 3405, 3437, 3469,
+    3501, 3533, 3565, 3598, 3630, 3663, 3696, 3729, 3762, 3796, 3829, 3863, 3897, 3931, 3966, 4000
+};
+
+unsigned int ramp[MAX_RAMP];                        // One TA0CCR1 value per PWM period
+
+volatile unsigned char fade_done;                   // Set by the DMA ISR (or Timer0 ISR)
+volatile unsigned int isr_step;                     // Next ramp[] entry for the Timer0 ISR
+unsigned int isr_steps;
+unsigned int *isr_ramp;
+
+unsigned char ramp_errors;
+volatile unsigned long isr_cycles_per_second;       // Timer0 ISR, one second of fading
+volatile unsigned int dma_isr_cycles;               // The one DMA ISR at the end of a fade
+unsigned long loops_idle;                           // count_loops() with no fade...
+unsigned long loops_with_dma;                       // ...and while the DMA fades
+unsigned long dma_cycles_per_second;
+unsigned int build_cycles;                          // fade_build() for FADE_STEPS
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned int start;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P9DIR = BIT7;                                   // Green LED
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // MCLK = SMCLK = 8MHz
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+    pwm_init();
+
+    // Fade up, the old way - one ISR every period
+    start = TA1R;
+    fade_build(ramp, FADE_STEPS, 0, MAX_LEVEL, FADE_LINEAR);
+    build_cycles = TA1R - start;
+    check_ramp(ramp, FADE_STEPS, 0, MAX_LEVEL);
+    TA0CCR1 = 0;
+    isr_fade(ramp, FADE_STEPS);
+
+    // Exponential fade down, then fade up again, with the DMA
+    fade_build(ramp, FADE_STEPS, MAX_LEVEL, 0, FADE_EXPONENTIAL);
+    check_ramp(ramp, FADE_STEPS, MAX_LEVEL, 0);
+    fade_start(ramp, FADE_STEPS);
+    fade_wait();
+
+    fade_build(ramp, FADE_STEPS, 0, MAX_LEVEL, FADE_LINEAR);
+    loops_idle = count_loops(0);
+    loops_with_dma = count_loops(ramp);
+
+    dma_cycles_per_second = (dma_isr_cycles * (unsigned long)PWM_HZ) / FADE_STEPS;
+    if(loops_with_dma < loops_idle)                 // Can be a loop or so over - then 0
+    {
+        dma_cycles_per_second = dma_cycles_per_second +
+            (unsigned long)(((unsigned long long)(loops_idle - loops_with_dma) * CPU_HZ) / loops_idle);
+    }
+
+    if(ramp_errors == 0)
+    {
+        P9OUT = BIT7;                               // Green LED - every ramp was right
+    }
+
+    // Breathe - down and back up, repeated by the DMA with no CPU at all
+    fade_build(ramp, FADE_STEPS, MAX_LEVEL, 0, FADE_LINEAR);
+    fade_build(ramp + FADE_STEPS, FADE_STEPS, 0, MAX_LEVEL, FADE_LINEAR);
+    fade_repeat(ramp, MAX_RAMP);
+
+    while(1)
+    {
+        _BIS_SR(LPM0_bits | GIE);                   // Nothing will wake us
+    }
+}
+
+// ******************************
+// PWM on P1.0
+// ******************************
+void pwm_init(void)
+{
+    P1DIR = BIT0;                                   // Red LED...
+    P1SEL0 = BIT0;                                  // ...driven by TA0.1
+    P1OUT = 0x00;
+
+    TA0CCR0 = PWM_PERIOD - 1;                       // 0 to 3999 = PWM_PERIOD counts
+    TA0CCR1 = 0;                                    // Off. PWM_PERIOD or more = on all the time
+    TA0CCTL1 = OUTMOD_7;                            // HI at 0, LO at TA0CCR1
+    TA0CTL = SMCLK | ID_3 | UP | TACLR;             // SMCLK / 8 = 1MHz
+}
+
+// ******************************
+// Work out a fade, one duty per PWM period
+// ******************************
+void fade_build(unsigned int *ramp, unsigned int steps,
+                unsigned char from, unsigned char to, unsigned char shape)
+{
+    unsigned int i;
+    long level;                                     // Brightness * 256
+    long target;
+    long step;
+
+    level = (long)from << 8;
+    target = (long)to << 8;
+
+    for(i = 0; i < steps; i = i + 1)
+    {
+        if(shape == FADE_LINEAR)
+        {
+            level = ((long)from << 8) + ((target - ((long)from << 8)) * (long)i) / (long)(steps - 1);
+        }
+        else if(i > 0)                              // FADE_EXPONENTIAL
+        {
+            step = (target - level) >> EXP_SHIFT;
+            if(step == 0)                           // The last few, one at a time
+            {
+                if(target > level)
+                {
+                    step = 1;
+                }
+                else if(target < level)
+                {
+                    step = -1;
+                }
+            }
+            level = level + step;
+        }
+        ramp[i] = gamma_table[level >> 8];
+    }
+    ramp[steps - 1] = gamma_table[to];              // Always end exactly on the target
+}
+
+// ******************************
+// DMA channel 0 - ramp[] into TA0CCR1
+// ******************************
+void fade_start(unsigned int *ramp, unsigned int steps)
+{
+    DMA0CTL = 0;
+    DMACTL0 = DMA0TSEL_1;                           // TA0CCR0 CCIFG - start of every period
+    __data20_write_long((unsigned long)&DMA0SA, (unsigned long)ramp);
+    __data20_write_long((unsigned long)&DMA0DA, (unsigned long)&TA0CCR1);
+    DMA0SZ = steps;
+    fade_done = 0;
+    DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMAIE | DMAEN; // Words, once
+}
+
+void fade_repeat(unsigned int *ramp, unsigned int steps)
+{
+    DMA0CTL = 0;
+    DMACTL0 = DMA0TSEL_1;
+    __data20_write_long((unsigned long)&DMA0SA, (unsigned long)ramp);
+    __data20_write_long((unsigned long)&DMA0DA, (unsigned long)&TA0CCR1);
+    DMA0SZ = steps;
+    DMA0CTL = DMADT_4 | DMASRCINCR_3 | DMADSTINCR_0 | DMAEN; // Starts over by itself
+}
+
+void fade_wait(void)
+{
+    _BIC_SR(GIE);                                   // No lost wake-up between test and sleep
+    while(!fade_done)
+    {
+        _BIS_SR(LPM0_bits | GIE);
+        _BIC_SR(GIE);
+    }
+    _BIS_SR(GIE);
+}
+
+void check_ramp(unsigned int *ramp, unsigned int steps, unsigned char from, unsigned char to)
+{
+    unsigned int i;
+
+    if((ramp[0] != gamma_table[from]) || (ramp[steps - 1] != gamma_table[to]))
+    {
+        ramp_errors = ramp_errors + 1;
+        return;
+    }
+    for(i = 1; i < steps; i = i + 1)
+    {
+        if(((to > from) && (ramp[i] < ramp[i - 1])) ||
+           ((to < from) && (ramp[i] > ramp[i - 1])))
+        {
+            ramp_errors = ramp_errors + 1;
+            return;
+        }
+    }
+}
+
+// ******************************
+// Benchmark - the same fade, one ISR per period
+// ******************************
+void isr_fade(unsigned int *ramp, unsigned int steps)
+{
+    isr_ramp = ramp;
+    isr_steps = steps;
+    isr_step = 0;
+    isr_cycles_per_second = 0;
+    fade_done = 0;
+
+    TA0CCTL0 = CCIE;                                // Every time Timer0 gets to TA0CCR0
+    fade_wait();
+}
+
+// ******************************
+// Benchmark - CPU left over while the DMA fades
+// ******************************
+unsigned long count_loops(unsigned int *ramp)
+{
+    unsigned long loops = 0;
+    unsigned char overflows = 0;
+
+    _BIC_SR(GIE);                                   // Only the DMA may take cycles
+    if(ramp != 0)
+    {
+        fade_start(ramp, FADE_STEPS);               // First word at the next PWM period
+    }
+    TA1CTL = TA1CTL & ~TAIFG;
+    while(!(TA1CTL & TAIFG));                       // Start on a Timer1 roll-over
+    TA1CTL = TA1CTL & ~TAIFG;
+
+    while(overflows < LOOP_OVERFLOWS)               // The same loop both times
+    {
+        loops = loops + 1;
+        if(TA1CTL & TAIFG)
+        {
+            TA1CTL = TA1CTL & ~TAIFG;
+            overflows = overflows + 1;
+        }
+    }
+
+    DMA0CTL = 0;                                    // Done - and no DMA ISR afterwards
+    _BIS_SR(GIE);
+    return loops;
+}
+
+// ******************************
+// Timer0 ISR - the old way (benchmark only)
+// ******************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    unsigned int start = TA1R;
+
+    TA0CCR1 = isr_ramp[isr_step];
+    isr_step = isr_step + 1;
+    if(isr_step >= isr_steps)
+    {
+        TA0CCTL0 = 0;                               // Done, no more interrupts
+        fade_done = 1;
+        __bic_SR_register_on_exit(LPM0_bits);
+    }
+
+    isr_cycles_per_second = isr_cycles_per_second + (unsigned int)(TA1R - start);
+}
+
+// ******************************
+// DMA ISR - a fade has finished
+// ******************************
+#pragma vector=DMA_VECTOR
+__interrupt void DMA_ISR(void)
+{
+    unsigned int start = TA1R;
+
+    switch(__even_in_range(DMAIV, DMAIV_DMA2IFG))
+    {
+        case DMAIV_DMA0IFG:
+        {
+            fade_done = 1;
+            __bic_SR_register_on_exit(LPM0_bits);   // Wake up main()
+            break;
+        }
+    }
+
+    dma_isr_cycles = TA1R - start;
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
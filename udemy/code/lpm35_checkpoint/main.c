@@ -0,0 +1,316 @@
+/*
+ * Saving a checkpoint in FRAM so a program can carry on after LPM3.5
+ *
+ * In LPM3.5 (and LPM4.5) the RAM is turned off. When the uC wakes up it starts main()
+ * again from the very beginning, so every variable is lost - which is why all our other
+ * programs stop at LPM0-LPM3. The way around this is a "checkpoint":
+ *
+ *  1. Before going to sleep, copy everything the program needs into FRAM
+ *  2. When main() starts, look at SYSRSTIV. SYSRSTIV_LPM5WU means we woke from LPMx.5
+ *  3. If so, copy the checkpoint back and skip the slow start-up (crystal, RTC set up)
+ *
+ * The program here is the odometer from loop_nested_challenge and the LED counter from
+ * timer_up_long, moved one step every second by the RTC 1Hz event. Its state (the five
+ * odometer digits, the interval counter and the LED) lives in struct app_state.
+ *
+ * TWO CHECKPOINT SLOTS
+ * --------------------
+ * If the power goes off while the checkpoint is being written, half of it could be old
+ * and half new. So there are two slots, and we always write the OLDER one. Each slot has
+ * a sequence number and a check value that is written LAST. When restoring we use the
+ * newest slot whose check value is right - a half written slot is just ignored. slots[]
+ * is volatile, so the compiler must do the stores in the order they are written in.
+ *
+ * RESUME TIME AND CURRENT
+ * -----------------------
+ * After any reset MCLK and SMCLK run at 1MHz. _system_pre_init() (called before the C
+ * start-up code) starts Timer1 from SMCLK, so TA1R is the number of microseconds since
+ * the uC woke up. These are kept in FRAM (the debugger is disconnected by LPM3.5):
+ *  - resume_us     wake-up until the checkpoint is restored and the pins are unlocked
+ *  - cold_boot_us  the same for a real reset, which has to wait for the crystal
+ *  - awake_us      wake-up until we go back to sleep (includes saving the checkpoint)
+ *
+ * awake_us is used to estimate the average current, compared with staying in LPM3 and
+ * counting seconds with Timer_A (where the RAM is kept, so nothing needs to be saved):
+ *      I = I_SLEEP + (awake time per second * I_ACTIVE)
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define DIGITS                  5                   // Odometer counts to 99999
+#define TOGGLE_SECONDS          5                   // Red LED toggles every 5 seconds
+#define CHECK_START             0xC0DE              // Check value of an empty state
+#define LPM3_NANOAMPS           900                 // Typical LPM3, crystal + Timer_A running
+#define LPM35_NANOAMPS          450                 // Typical LPM3.5, crystal + RTC running
+#define ACTIVE_MICROAMPS        120                 // Typical active current at 1MHz
+#define TIMER_ISR_US            20                  // About how long a Timer_A ISR keeps us awake
+
+struct app_state
+{
+    unsigned char digits[DIGITS];                   // Odometer, digits[0] is the ones
+    unsigned char red_led_on;
+    unsigned int intervals;                         // Seconds since the LED last toggled
+};
+
+struct checkpoint
+{
+    unsigned int sequence;                          // Bigger is newer
+    struct app_state state;
+    unsigned int check;                             // Written last
+};
+
+// ********************
+// Function Definitions
+// ********************
+void start_crystal(void);                           // 32768Hz LFXT on PJ.4 / PJ.5
+void rtc_start(void);                               // Calendar mode
+void rtc_enable_1hz(void);                          // RTCRDYIE
+void advance(struct app_state *state);              // One second of the application
+unsigned int check_value(const volatile struct checkpoint *slot);
+void save_checkpoint(const struct app_state *state);
+unsigned char restore_checkpoint(struct app_state *state);
+void enter_lpm35(void);
+
+#pragma PERSISTENT(slots)
+volatile struct checkpoint slots[2] = {{0}};        // In FRAM through LPM3.5, stored in order
+#pragma PERSISTENT(resume_us)
+unsigned int resume_us = 0;
+#pragma PERSISTENT(cold_boot_us)
+unsigned int cold_boot_us = 0;
+#pragma PERSISTENT(awake_us)
+unsigned int awake_us = 0;
+#pragma PERSISTENT(bad_checkpoints)
+unsigned int bad_checkpoints = 0;                   // Wake-ups with no good slot to restore
+
+unsigned long lpm35_nanoamps;                       // Average current estimates
+unsigned long lpm3_nanoamps;
+volatile unsigned char second_passed;               // Set by the RTC ISR
+
+// ******************************************************
+// Called by the start-up code before main(). Starts the
+// microsecond timer as early as we can after waking up.
+// ******************************************************
+int _system_pre_init(void)
+{
+    WDTCTL = WDTPW | WDTHOLD;
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // SMCLK is 1MHz after a reset
+    return 1;
+}
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    struct app_state state;
+    unsigned char resumed = 0;
+    unsigned char i;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+
+    PJSEL0 = BIT4 | BIT5;                           // PJ.4 and PJ.5 are for the crystal
+    if(SYSRSTIV == SYSRSTIV_LPM5WU)                 // Woken from LPM3.5 by the RTC
+    {
+        resumed = restore_checkpoint(&state);
+        if(!resumed)
+        {
+            bad_checkpoints = bad_checkpoints + 1;
+        }
+    }
+
+    if(!resumed)                                    // Real reset - full start-up
+    {
+        for(i = 0; i < DIGITS; i = i + 1)
+        {
+            state.digits[i] = 0;
+        }
+        state.red_led_on = 0;
+        state.intervals = 0;
+        start_crystal();
+        rtc_start();
+    }
+
+    // Pins must be set up the way they were BEFORE they are unlocked
+    P1DIR = BIT0;
+    P9DIR = BIT7;
+    P9OUT = 0x00;
+    if(state.red_led_on)
+    {
+        P1OUT = BIT0;
+    }
+    else
+    {
+        P1OUT = 0x00;
+    }
+    rtc_enable_1hz();
+    PM5CTL0 = ENABLE_PINS;                          // Unlock the pins
+
+    if(resumed)
+    {
+        resume_us = TA1R;
+    }
+    else
+    {
+        cold_boot_us = TA1R;
+    }
+
+    _BIS_SR(GIE);                                   // The waiting RTC interrupt runs here
+    __no_operation();
+
+    if(second_passed)
+    {
+        advance(&state);
+    }
+    save_checkpoint(&state);
+
+    awake_us = TA1R;
+    lpm35_nanoamps = LPM35_NANOAMPS + ((unsigned long)awake_us * ACTIVE_MICROAMPS) / 1000;
+    lpm3_nanoamps = LPM3_NANOAMPS + ((unsigned long)TIMER_ISR_US * ACTIVE_MICROAMPS) / 1000;
+
+    enter_lpm35();                                  // We never come back here
+    while(1);
+}
+
+// ******************************
+// The application - one second
+// ******************************
+void advance(struct app_state *state)
+{
+    unsigned char i;
+
+    state->intervals = state->intervals + 1;
+    if(state->intervals == TOGGLE_SECONDS)
+    {
+        state->intervals = 0;
+        state->red_led_on = state->red_led_on ^ 1;
+        P1OUT = P1OUT ^ BIT0;
+    }
+
+    for(i = 0; i < DIGITS; i = i + 1)               // Odometer - 99999 rolls over to 00000
+    {
+        state->digits[i] = state->digits[i] + 1;
+        if(state->digits[i] < 10)
+        {
+            break;                                  // No carry
+        }
+        state->digits[i] = 0;
+    }
+}
+
+// ******************************
+// Checkpoint in FRAM
+// ******************************
+unsigned int check_value(const volatile struct checkpoint *slot)
+{
+    const volatile unsigned char *byte = (const volatile unsigned char *)&slot->state;
+    unsigned int check = CHECK_START ^ slot->sequence;
+    unsigned int i;
+
+    for(i = 0; i < sizeof(struct app_state); i = i + 1)
+    {
+        check = (check << 1) + (check >> 15) + byte[i];  // Rotate and add
+    }
+    return check;
+}
+
+void save_checkpoint(const struct app_state *state)
+{
+    volatile struct checkpoint *older;
+    unsigned int newest;
+
+    if(slots[0].sequence - slots[1].sequence < 0x8000)  // Works when sequence rolls over
+    {
+        older = &slots[1];
+        newest = slots[0].sequence;
+    }
+    else
+    {
+        older = &slots[0];
+        newest = slots[1].sequence;
+    }
+
+    older->check = 0;                               // Not valid while we write it
+    older->state = *state;
+    older->sequence = newest + 1;
+    older->check = check_value(older);              // Now it is
+}
+
+unsigned char restore_checkpoint(struct app_state *state)
+{
+    unsigned char good0 = (slots[0].check == check_value(&slots[0]));
+    unsigned char good1 = (slots[1].check == check_value(&slots[1]));
+
+    if(good0 && (!good1 || (slots[0].sequence - slots[1].sequence < 0x8000)))
+    {
+        *state = slots[0].state;
+        return 1;
+    }
+    if(good1)
+    {
+        *state = slots[1].state;
+        return 1;
+    }
+    return 0;
+}
+
+// ******************************
+// Clock and RTC set up
+// ******************************
+void start_crystal(void)
+{
+    CSCTL0 = 0xA500;                                // "Password" to access clock registers
+    CSCTL4 = CSCTL4 & ~LFXTOFF;                     // Turn on the 32768Hz crystal
+    do
+    {
+        CSCTL5 = CSCTL5 & ~LFXTOFFG;                // Clear the crystal fault flag...
+        SFRIFG1 = SFRIFG1 & ~OFIFG;
+    } while(SFRIFG1 & OFIFG);                       // ...until the crystal has started
+    CSCTL0_H = 0;                                   // Lock the clock registers
+}
+
+void rtc_start(void)
+{
+    RTCCTL0_H = RTCKEY_H;                           // "Password" to change the RTC
+    RTCCTL1 = RTCHOLD | RTCMODE;                    // Stop it and use calendar mode
+    RTCSEC = 0;
+    RTCCTL1 = RTCCTL1 & ~RTCHOLD;                   // Start counting
+    RTCCTL0_H = 0;                                  // Lock the RTC
+}
+
+void rtc_enable_1hz(void)
+{
+    RTCCTL0_H = RTCKEY_H;
+    RTCCTL0_L = RTCCTL0_L | RTCRDYIE;               // OR it in - keep the flag that woke us
+    RTCCTL0_H = 0;
+}
+
+// ******************************
+// LPM3.5
+// ******************************
+void enter_lpm35(void)
+{
+    PMMCTL0_H = PMMPW_H;                            // "Password" for the power manager
+    PMMCTL0_L = PMMCTL0_L | PMMREGOFF;              // Turn the regulator off when we sleep
+    PMMCTL0_L = PMMCTL0_L & ~SVSHE;
+    PMMCTL0_H = 0;
+    _BIS_SR(LPM4_bits | GIE);                       // With the regulator off this is LPM3.5
+}
+
+// ******************************
+// RTC ISR
+// ******************************
+#pragma vector=RTC_VECTOR
+__interrupt void RTC_ISR(void)
+{
+    switch(__even_in_range(RTCIV, RTCIV_RT1PSIFG))
+    {
+        case RTCIV_RTCRDYIFG:                       // 1Hz event
+        {
+            second_passed = 1;
+            break;
+        }
+    }
+}
@@ -0,0 +1,200 @@
+/*
+ * Running hot functions and tables from RAM instead of FRAM
+ *
+ * Our programs are stored in FRAM, and the CPU normally runs them straight from FRAM.
+ * FRAM can only be read at up to 8MHz. If select_clock_signals() is changed to run
+ * MCLK at 16MHz, the FRAM controller has to add a "wait state" (the CPU waits one extra
+ * clock for FRAM) every time it reads an instruction or a table that is not already in
+ * the small FRAM cache. RAM never needs wait states.
+ *
+ * This program shows how to make a function (or an ISR, or a table) run from RAM:
+ *
+ *  1. Put it in the .TI.ramfunc section (code) or the .ramconst section (tables):
+ *          #pragma CODE_SECTION(my_function, ".TI.ramfunc")
+ *          #pragma DATA_SECTION(my_table, ".ramconst")
+ *
+ *  2. lnk_msp430fr6989.cmd stores these sections in FRAM ("load") but links them to
+ *     run at a RAM address ("run"). .TI.ramfunc is already in every project's .cmd
+ *     file; this project's adds .ramconst the same way. table(BINIT) puts both in the
+ *     "boot-time copy table".
+ *
+ *  3. The start-up code (before main()) copies everything in the BINIT table from FRAM
+ *     to RAM. There is nothing to write - no copy loop, no linker symbols.
+ *
+ * Remember RAM is only 2KB (see lnk_msp430fr6989.cmd) and is shared with the stack and
+ * all variables, so only put the functions that run the most (ISRs, CRC or filter
+ * loops) in RAM.
+ *
+ * BENCHMARK
+ * ---------
+ * The same CRC kernel is built twice, once in FRAM (crc16_fram) and once in RAM
+ * (crc16_ram), each with its own copy of the table. Both are timed with Timer1 running
+ * from SMCLK, which is the same clock as MCLK, so 1 count = 1 CPU cycle. This is done
+ * with MCLK at 8MHz (no wait states) and at 16MHz (one wait state). The results are in
+ * crc_cycles[speed][memory] for the debugger. The Timer0 ISR also runs from RAM.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define CLOCK_8MHZ              0x0046              // DCORSEL | DCOFSEL_3 = 8MHz
+#define CLOCK_16MHZ             0x0048              // DCORSEL | DCOFSEL_4 = 16MHz
+#define CRC_SEED                0xFFFF              // CRC-16-CCITT starting value
+#define BUFFER_SIZE             64                  // Bytes checked by the benchmark
+
+// Index into crc_cycles[][]
+#define AT_8MHZ                 0
+#define AT_16MHZ                1
+#define IN_FRAM                 0
+#define IN_RAM                  1
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(unsigned int speed);                  // MCLK = SMCLK = 8 or 16MHz
+unsigned int crc16_fram(const unsigned char *data, unsigned int length);
+unsigned int crc16_ram(const unsigned char *data, unsigned int length);
+unsigned int time_crc(unsigned char memory);                    // Cycles for one CRC of buffer[]
+
+#pragma CODE_SECTION(crc16_ram, ".TI.ramfunc")
+
+// CRC-16-CCITT, 4 bits at a time. A 16 entry table is a good trade between speed and size.
+const unsigned int crc_table_fram[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+#pragma DATA_SECTION(crc_table_ram, ".ramconst")
+const unsigned int crc_table_ram[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+unsigned char buffer[BUFFER_SIZE];                              // Data the benchmark checks
+unsigned int crc_cycles[2][2];                                  // [AT_8MHZ/AT_16MHZ][IN_FRAM/IN_RAM]
+unsigned int crc_result[2];                                     // Both copies must give the same answer
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned int i;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable inputs and outputs
+
+    P1DIR = BIT0;                                               // P1.0 red LED is an output
+    P1OUT = 0x00;
+
+    for(i = 0; i < BUFFER_SIZE; i = i + 1)                      // Something to check
+    {
+        buffer[i] = i;
+    }
+
+    select_clock_signals(CLOCK_8MHZ);
+    crc_cycles[AT_8MHZ][IN_FRAM] = time_crc(IN_FRAM);
+    crc_cycles[AT_8MHZ][IN_RAM] = time_crc(IN_RAM);
+
+    select_clock_signals(CLOCK_16MHZ);
+    crc_cycles[AT_16MHZ][IN_FRAM] = time_crc(IN_FRAM);
+    crc_cycles[AT_16MHZ][IN_RAM] = time_crc(IN_RAM);
+
+    crc_result[IN_FRAM] = crc16_fram(buffer, BUFFER_SIZE);
+    crc_result[IN_RAM] = crc16_ram(buffer, BUFFER_SIZE);
+
+    TA0CCR0 = 40000;                                            // (40000 * 25us) = 1sec
+    TA0CTL = ACLK | UP;                                         // ACLK source in UP mode
+    TA0CCTL0 = CCIE;                                            // Enable interrupts for Timer0
+
+    _BIS_SR(LPM0_bits | GIE);                                   // The ISR (in RAM) blinks the LED
+    while(1);
+}
+
+// *********************************
+// Timer0 ISR - runs from RAM
+// *********************************
+#pragma CODE_SECTION(Timer0_ISR, ".TI.ramfunc")
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    P1OUT = P1OUT ^ BIT0;                                       // Toggle red LED
+}
+
+// *********************************
+// The CRC kernel, once for each memory
+// *********************************
+unsigned int crc16_fram(const unsigned char *data, unsigned int length)
+{
+    unsigned int crc = CRC_SEED;
+
+    while(length > 0)
+    {
+        crc = (crc << 4) ^ crc_table_fram[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crc_table_fram[(crc >> 12) ^ (*data & 0x0F)];
+        data = data + 1;
+        length = length - 1;
+    }
+    return crc;
+}
+
+unsigned int crc16_ram(const unsigned char *data, unsigned int length)
+{
+    unsigned int crc = CRC_SEED;
+
+    while(length > 0)
+    {
+        crc = (crc << 4) ^ crc_table_ram[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crc_table_ram[(crc >> 12) ^ (*data & 0x0F)];
+        data = data + 1;
+        length = length - 1;
+    }
+    return crc;
+}
+
+unsigned int time_crc(unsigned char memory)
+{
+    unsigned int start;
+    unsigned int end;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;                        // 1 count = 1 MCLK cycle
+
+    start = TA1R;
+    if(memory == IN_FRAM)
+    {
+        crc16_fram(buffer, BUFFER_SIZE);
+    }
+    else
+    {
+        crc16_ram(buffer, BUFFER_SIZE);
+    }
+    end = TA1R;
+
+    TA1CTL = 0;
+    return end - start;
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(unsigned int speed)
+{
+    if(speed == CLOCK_16MHZ)
+    {
+        FRCTL0 = FRCTLPW | NWAITS_1;    // FRAM needs 1 wait state above 8MHz - set it BEFORE speeding up
+    }
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = speed;                     // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+    if(speed != CLOCK_16MHZ)
+    {
+        FRCTL0 = FRCTLPW;               // No wait states needed - remove them AFTER slowing down
+    }
+}
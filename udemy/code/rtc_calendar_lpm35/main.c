@@ -0,0 +1,269 @@
+/*
+ * Keeping time with the Real-Time Clock (RTC_C) and sleeping in LPM3.5
+ *
+ * timer_up_20seconds, timer_up_long and uart_challenge_2 count seconds by adding up
+ * 40000 * 25us Timer_A intervals. That has some problems:
+ *  - The 25us only holds for one ACLK setting, change the divider and the time is wrong
+ *  - Timer_A (and ACLK) must stay on, so we can never go below LPM3
+ *  - The CPU wakes up every second just to add one to a counter
+ *
+ * The RTC_C module counts seconds, minutes, hours, days, months and years by itself
+ * (calendar mode) from the 32768Hz crystal on the LaunchPad (LFXT, pins PJ.4 and PJ.5).
+ * It can interrupt:
+ *  - once a second (RTCRDYIFG - the "1Hz event", set when the time registers are safe
+ *    to read)
+ *  - when the minute or hour changes (RTCTEVIFG - the "time event", RTCTEV_0 or RTCTEV_1)
+ *  - at a set minute and/or hour (RTCAIFG - the alarm)
+ *
+ * The RTC keeps running in LPM3.5, the lowest power mode that still keeps time. In LPM3.5
+ * almost everything else is turned off - even the RAM. When the RTC interrupt wakes the
+ * uC, it starts from the very beginning of main() again, just like a reset. We can tell
+ * it was the RTC (and not a real reset) because SYSRSTIV says SYSRSTIV_LPM5WU.
+ *
+ * Anything we need to remember while asleep is kept in FRAM using #pragma PERSISTENT.
+ * Here we keep the number of wake-ups and whether the red LED was on. The pins keep their
+ * value while asleep (that is why PM5CTL0 = ENABLE_PINS is in every program - it unlocks
+ * them), but we have to set P1OUT and P1DIR back the way they were BEFORE unlocking.
+ *
+ * This program wakes up once a minute (RTCTEV_0), toggles the red LED and goes straight
+ * back to LPM3.5. After a real reset it also sets the alarm with rtc_set_alarm() for
+ * ALARM_HOUR:ALARM_MINUTE (five minutes after the start time, then once a day), which
+ * toggles the green LED. The alarm is on a minute change, so it adds no wake-ups.
+ *
+ * The 1Hz event is on for the first ONE_HZ_SECONDS seconds after a real reset: each
+ * second the ISR copies the time into clock_hour, clock_minute and clock_second (watch
+ * them in the debugger) and counts it in one_hz_events. Then it turns RTCRDYIE off
+ * again - waking every second all month would cost as much as counting with Timer_A.
+ *
+ * WAKE-UPS AND ENERGY
+ * -------------------
+ * Over a 31 day month (2,678,400 seconds):
+ *  - counting seconds with Timer_A:   2,678,400 wake-ups, Timer_A + ACLK on all the time (LPM3)
+ *  - RTC minute event and LPM3.5:        44,640 wake-ups, only the RTC and crystal on (LPM3.5)
+ *
+ * With the typical datasheet currents below (3V, 25C) the average current is roughly:
+ *      I = I_SLEEP + (wake-ups per second * charge per wake-up)
+ * wakeups holds the real number of wake-ups so far, and estimate_nanoamps() works out the
+ * average current for each method using the same wake-up cost.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SECONDS_PER_MONTH       2678400UL           // 31 days
+#define LPM3_NANOAMPS           900                 // Typical LPM3, crystal + Timer_A running
+#define LPM35_NANOAMPS          450                 // Typical LPM3.5, crystal + RTC running
+#define ALARM_HOUR              12                  // 12:05, five minutes after the start time
+#define ALARM_MINUTE            5
+#define ONE_HZ_SECONDS          30                  // 1Hz events after a real reset
+#define WAKE_NANOAMP_SECONDS    500                 // Typical charge for one short wake-up (nA * s)
+                                                    // (about 250us at 2mA, start-up included)
+
+// ********************
+// Function Definitions
+// ********************
+void start_crystal(void);                           // 32768Hz LFXT on PJ.4 / PJ.5
+void rtc_start_calendar(void);                      // Sets the date and starts the RTC
+void rtc_enable_interrupts(void);                   // Minute event, and 1Hz for a while
+void rtc_one_hz(unsigned char on);                  // RTCRDYIE on (1) or off (0)
+void rtc_set_alarm(unsigned char hour, unsigned char minute); // Every day at hour:minute
+void enter_lpm35(void);                             // Goes to sleep - wakes up in main()
+unsigned long estimate_nanoamps(unsigned long wakeups_per_month, unsigned long sleep_nanoamps);
+
+#pragma PERSISTENT(wakeups)
+unsigned long wakeups = 0;                          // Kept in FRAM through LPM3.5
+#pragma PERSISTENT(red_led_on)
+unsigned char red_led_on = 0;
+#pragma PERSISTENT(green_led_on)
+unsigned char green_led_on = 0;                     // Toggled by the alarm
+#pragma PERSISTENT(one_hz_events)
+unsigned int one_hz_events = 0;                     // Up to ONE_HZ_SECONDS
+#pragma PERSISTENT(clock_hour)
+unsigned char clock_hour = 0;                       // Time of the last 1Hz event
+#pragma PERSISTENT(clock_minute)
+unsigned char clock_minute = 0;
+#pragma PERSISTENT(clock_second)
+unsigned char clock_second = 0;
+
+unsigned long timer_a_nanoamps;                     // Average current estimates
+unsigned long rtc_nanoamps;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned int reset_reason;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+
+    reset_reason = SYSRSTIV;                        // Why are we in main()?
+
+    // Pins must be set up the way they were BEFORE they are unlocked
+    P1DIR = BIT0;
+    P9DIR = BIT7;
+    if(green_led_on)
+    {
+        P9OUT = BIT7;
+    }
+    else
+    {
+        P9OUT = 0x00;
+    }
+    if(red_led_on)
+    {
+        P1OUT = BIT0;
+    }
+    else
+    {
+        P1OUT = 0x00;
+    }
+    PJSEL0 = BIT4 | BIT5;                           // PJ.4 and PJ.5 are for the crystal
+
+    if(reset_reason != SYSRSTIV_LPM5WU)             // A real reset, not the RTC waking us
+    {
+        start_crystal();
+        rtc_start_calendar();
+        rtc_set_alarm(ALARM_HOUR, ALARM_MINUTE);    // The RTC keeps it through LPM3.5
+        one_hz_events = 0;                          // 1Hz events again for a while
+    }
+    rtc_enable_interrupts();
+
+    PM5CTL0 = ENABLE_PINS;                          // Unlock the pins - this also lets the
+                                                    // waiting RTC interrupt through
+    _BIS_SR(GIE);                                   // RTC_ISR runs here if we were woken up
+    __no_operation();
+
+    timer_a_nanoamps = estimate_nanoamps(SECONDS_PER_MONTH, LPM3_NANOAMPS);
+    rtc_nanoamps = estimate_nanoamps(SECONDS_PER_MONTH / 60, LPM35_NANOAMPS);
+
+    enter_lpm35();                                  // We never come back here
+    while(1);
+}
+
+// ******************************
+// Clock and RTC set up
+// ******************************
+void start_crystal(void)
+{
+    CSCTL0 = 0xA500;                                // "Password" to access clock registers
+    CSCTL4 = CSCTL4 & ~LFXTOFF;                     // Turn on the 32768Hz crystal
+    do
+    {
+        CSCTL5 = CSCTL5 & ~LFXTOFFG;                // Clear the crystal fault flag...
+        SFRIFG1 = SFRIFG1 & ~OFIFG;
+    } while(SFRIFG1 & OFIFG);                       // ...until the crystal has started
+    CSCTL0_H = 0;                                   // Lock the clock registers
+}
+
+void rtc_start_calendar(void)
+{
+    RTCCTL0_H = RTCKEY_H;                           // "Password" to change the RTC
+    RTCCTL1 = RTCHOLD | RTCMODE;                    // Stop it and use calendar mode (binary)
+
+    RTCYEAR = 2019;                                 // Start date and time
+    RTCMON = 6;
+    RTCDAY = 11;
+    RTCDOW = 2;                                     // Tuesday
+    RTCHOUR = 12;
+    RTCMIN = 0;
+    RTCSEC = 0;
+
+    RTCCTL1 = RTCCTL1 & ~RTCHOLD;                   // Start counting
+    RTCCTL0_H = 0;                                  // Lock the RTC
+}
+
+void rtc_enable_interrupts(void)
+{
+    RTCCTL0_H = RTCKEY_H;
+    RTCCTL1 = (RTCCTL1 & ~RTCTEV_3) | RTCTEV_0;     // Time event when the minute changes
+                                                    // (RTCTEV_1 for every hour)
+    RTCCTL0_L = RTCCTL0_L | RTCTEVIE;               // Minute event. OR it in - writing the whole
+                                                    // register would clear the flag that woke us
+                                                    // (and RTCAIE from rtc_set_alarm())
+    RTCCTL0_H = 0;
+
+    rtc_one_hz(one_hz_events < ONE_HZ_SECONDS);
+}
+
+void rtc_one_hz(unsigned char on)
+{
+    RTCCTL0_H = RTCKEY_H;
+    if(on)
+    {
+        RTCCTL0_L = RTCCTL0_L | RTCRDYIE;           // Once a second in calendar mode
+    }
+    else
+    {
+        RTCCTL0_L = RTCCTL0_L & ~RTCRDYIE;
+    }
+    RTCCTL0_H = 0;
+}
+
+void rtc_set_alarm(unsigned char hour, unsigned char minute)
+{
+    RTCCTL0_H = RTCKEY_H;
+    RTCCTL0_L = RTCCTL0_L & ~RTCAIE;                // Alarm off while we change it
+    RTCAMIN = minute | BIT7;                        // BIT7 (AE) - this field must match
+    RTCAHOUR = hour | BIT7;                         // Leave BIT7 clear to alarm every hour
+    RTCADOW = 0;                                    // Any day
+    RTCADAY = 0;
+    RTCCTL0_L = (RTCCTL0_L & ~RTCAIFG) | RTCAIE;
+    RTCCTL0_H = 0;
+}
+
+// ******************************
+// LPM3.5
+// ******************************
+void enter_lpm35(void)
+{
+    PMMCTL0_H = PMMPW_H;                            // "Password" for the power manager
+    PMMCTL0_L = PMMCTL0_L | PMMREGOFF;              // Turn the regulator off when we sleep
+    PMMCTL0_L = PMMCTL0_L & ~SVSHE;                 // Supply monitor off saves a bit more
+    PMMCTL0_H = 0;
+    _BIS_SR(LPM4_bits | GIE);                       // With the regulator off this is LPM3.5
+}
+
+unsigned long estimate_nanoamps(unsigned long wakeups_per_month, unsigned long sleep_nanoamps)
+{
+    return sleep_nanoamps + (wakeups_per_month * WAKE_NANOAMP_SECONDS) / SECONDS_PER_MONTH;
+}
+
+// ******************************
+// RTC ISR
+// ******************************
+#pragma vector=RTC_VECTOR
+__interrupt void RTC_ISR(void)
+{
+    switch(__even_in_range(RTCIV, RTCIV_RT1PSIFG))
+    {
+        case RTCIV_RTCRDYIFG:                       // 1Hz event - the time is safe to read
+        {
+            clock_hour = RTCHOUR;
+            clock_minute = RTCMIN;
+            clock_second = RTCSEC;
+            wakeups = wakeups + 1;
+            one_hz_events = one_hz_events + 1;
+            if(one_hz_events >= ONE_HZ_SECONDS)
+            {
+                rtc_one_hz(0);                      // Back to one wake-up a minute
+            }
+            break;
+        }
+
+        case RTCIV_RTCTEVIFG:                       // Minute changed
+        {
+            wakeups = wakeups + 1;
+            red_led_on = red_led_on ^ 1;
+            P1OUT = P1OUT ^ BIT0;
+            break;
+        }
+
+        case RTCIV_RTCAIFG:                         // Alarm time reached
+        {
+            green_led_on = green_led_on ^ 1;
+            P9OUT = P9OUT ^ BIT7;
+            break;
+        }
+    }
+}
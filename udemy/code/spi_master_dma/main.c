@@ -0,0 +1,380 @@
+/*
+ * SPI master on eUSCI_B0 with DMA transfers and a transaction queue
+ *
+ * The UART programs use eUSCI_A0 to send one byte at a time, a few thousand bits per
+ * second. External flash chips and sensors use SPI instead: the master drives a clock
+ * (UCB0CLK) and on every clock one bit goes out on SIMO and one bit comes back on SOMI,
+ * so SPI is always "full duplex" - each byte sent is also a byte received. SPI has no
+ * addresses; every device has its own Chip Select (CS) pin that we pull LO to talk to it.
+ *
+ *      P1.4  UCB0CLK   clock out
+ *      P1.6  UCB0SIMO  data out (Slave In, Master Out)
+ *      P1.7  UCB0SOMI  data in  (Slave Out, Master In)
+ *      P1.3  CS of device 0,  P1.5  CS of device 1   (ordinary outputs)
+ *
+ * Each device in devices[] has its own SPI mode (clock polarity and phase) and clock
+ * divider. The SPI clock is SMCLK / divider, with SMCLK from select_clock_signals().
+ *
+ * DMA
+ * ---
+ * At 8MHz a byte takes only 8 SMCLK cycles, far too fast for an ISR per byte. So:
+ *  - DMA channel 0 copies UCB0RXBUF into the receive buffer every time a byte arrives
+ *    (UCB0RXIFG0 is DMA trigger 18)
+ *  - DMA channel 1 copies the next byte into UCB0TXBUF every time there is room
+ *    (UCB0TXIFG0 is DMA trigger 19)
+ * Channel 0 has the higher priority, so a byte is always read before the next one can
+ * overwrite it. When channel 0 has received the last byte, the DMA ISR runs once.
+ *
+ * TRANSACTION QUEUE
+ * -----------------
+ * spi_submit() puts a struct spi_transaction in a queue and returns straight away. The
+ * DMA ISR finishes the current transaction (CS back HI, finished = 1) and starts the next
+ * one itself, so back-to-back transfers do not wait for main() to wake up.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * Connect P1.6 (SIMO) to P1.7 (SOMI) with a jumper wire, so the "slave" answers with
+ * exactly what we send. loopback_ok is 1 if every byte came back. Then, for each SMCLK
+ * setting in clock_presets[], BENCH_TRANSACTIONS transactions are queued at SPI clock =
+ * SMCLK and timed with Timer1 (1 count = 1 SMCLK cycle). The results are in
+ * bytes_per_second[] (divide by 1000000 for MB/s) and efficiency_percent[] (how much of
+ * the time the SPI clock was actually running).
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE                          // Required to use inputs and outputs
+#define SMCLK                   0x0200                          // Timer_A SMCLK source
+#define CONTINUOUS              0x0020                          // Timer_A CONTINUOUS mode
+
+#define SPI_MODE_0              UCCKPH                          // Clock idles LO, data read on rising edge
+#define SPI_MODE_1              0                               // Clock idles LO, data read on falling edge
+#define SPI_MODE_2              (UCCKPL | UCCKPH)               // Clock idles HI, data read on falling edge
+#define SPI_MODE_3              UCCKPL                          // Clock idles HI, data read on rising edge
+#define SPI_QUEUE_SIZE          8                               // Must be a power of 2
+#define SPI_IDLE_BYTE           0xFF                            // Sent when there is nothing to send
+
+#define NUMBER_OF_DEVICES       2
+#define FLASH                   0                               // Index into devices[]
+#define BENCH                   1
+#define NUMBER_OF_PRESETS       4
+#define BENCH_TRANSACTIONS      4
+#define BENCH_SIZE              64                              // Bytes per transaction
+
+struct spi_device
+{
+    volatile unsigned char *cs_out;                             // PxOUT of the CS pin
+    unsigned char cs_bit;
+    unsigned int mode;                                          // SPI_MODE_0 to SPI_MODE_3
+    unsigned int divider;                                       // SPI clock = SMCLK / divider
+};
+
+struct spi_transaction
+{
+    unsigned char device;                                       // Index into devices[]
+    const unsigned char *tx;                                    // 0 - send SPI_IDLE_BYTE
+    unsigned char *rx;                                          // 0 - throw the answer away
+    unsigned int length;
+    volatile unsigned char finished;                            // Set by the DMA ISR
+};
+
+struct clock_preset
+{
+    unsigned int csctl1;                                        // Value for CSCTL1
+    unsigned long hz;
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(unsigned int csctl1);                 // MCLK = SMCLK
+void spi_init(void);                                            // Pins, eUSCI_B0 and DMA triggers
+void spi_configure(unsigned int mode, unsigned int divider);
+unsigned char spi_submit(struct spi_transaction *transaction);  // 0 if the queue is full
+void spi_wait(struct spi_transaction *transaction);
+void spi_start_next(void);                                      // Called with interrupts off
+void run_benchmark(unsigned char preset);
+
+const struct spi_device devices[NUMBER_OF_DEVICES] =
+{
+    {&P1OUT, BIT3, SPI_MODE_0, 4},                              // FLASH - SMCLK / 4
+    {&P1OUT, BIT5, SPI_MODE_0, 1}                               // BENCH - as fast as possible
+};
+
+const struct clock_preset clock_presets[NUMBER_OF_PRESETS] =
+{
+    {0x0000,  1000000},                                         // DCOFSEL_0
+    {0x0006,  4000000},                                         // DCOFSEL_3
+    {0x0046,  8000000},                                         // DCORSEL | DCOFSEL_3 (select_clock_signals)
+    {0x0048, 16000000}                                          // DCORSEL | DCOFSEL_4
+};
+
+struct spi_transaction *queue[SPI_QUEUE_SIZE];                  // Waiting transactions
+volatile unsigned char queue_head;                              // Next to start (DMA ISR)
+volatile unsigned char queue_tail;                              // Next free place (spi_submit)
+struct spi_transaction * volatile active;                       // On the wire now, 0 if idle
+unsigned int current_mode;                                      // What eUSCI_B0 is set up for
+unsigned int current_divider;
+const unsigned char idle_byte = SPI_IDLE_BYTE;
+unsigned char dummy_rx;
+
+unsigned char tx_buffer[BENCH_SIZE];
+unsigned char rx_buffer[BENCH_SIZE];
+struct spi_transaction bench[BENCH_TRANSACTIONS];
+
+unsigned char loopback_ok;
+unsigned long bytes_per_second[NUMBER_OF_PRESETS];
+unsigned int efficiency_percent[NUMBER_OF_PRESETS];
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    struct spi_transaction check;
+    unsigned char i;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable inputs and outputs
+
+    P1DIR = BIT0;                                               // Red LED
+    P9DIR = BIT7;                                               // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals(0x0046);                               // SMCLK = 8MHz
+    spi_init();
+    _BIS_SR(GIE);
+
+    for(i = 0; i < BENCH_SIZE; i = i + 1)
+    {
+        tx_buffer[i] = i * 7 + 1;
+        rx_buffer[i] = 0;
+    }
+
+    // Loopback test on the FLASH device settings
+    check.device = FLASH;
+    check.tx = tx_buffer;
+    check.rx = rx_buffer;
+    check.length = BENCH_SIZE;
+    spi_submit(&check);
+    spi_wait(&check);
+
+    loopback_ok = 1;
+    for(i = 0; i < BENCH_SIZE; i = i + 1)
+    {
+        if(rx_buffer[i] != tx_buffer[i])
+        {
+            loopback_ok = 0;
+        }
+    }
+
+    for(i = 0; i < NUMBER_OF_PRESETS; i = i + 1)
+    {
+        run_benchmark(i);
+    }
+    select_clock_signals(0x0046);
+
+    if(loopback_ok)
+    {
+        P9OUT = BIT7;                                           // Green - data came back
+    }
+    else
+    {
+        P1OUT = BIT0;                                           // Red - check the jumper wire
+    }
+
+    while(1);
+}
+
+// ****************************************************
+// SPI driver
+// ****************************************************
+void spi_init(void)
+{
+    P1OUT = P1OUT | BIT3 | BIT5;                                // CS pins HI (not selected)...
+    P1DIR = P1DIR | BIT3 | BIT5;                                // ...before they become outputs
+
+    P1SEL1 = P1SEL1 & ~(BIT4 | BIT6 | BIT7);
+    P1SEL0 = P1SEL0 | BIT4 | BIT6 | BIT7;                       // CLK, SIMO and SOMI to eUSCI_B0
+
+    DMACTL0 = DMA0TSEL_18 | DMA1TSEL_19;                        // UCB0RXIFG0 and UCB0TXIFG0
+
+    active = 0;
+    queue_head = 0;
+    queue_tail = 0;
+    spi_configure(devices[0].mode, devices[0].divider);
+}
+
+void spi_configure(unsigned int mode, unsigned int divider)
+{
+    UCB0CTLW0 = UCSWRST;                                        // Stop while we change it
+    UCB0CTLW0 = UCSWRST | UCSSEL__SMCLK | UCMST | UCSYNC | UCMSB | mode;
+    UCB0BRW = divider;
+    UCB0CTLW0 = UCB0CTLW0 & ~UCSWRST;                           // Go
+    current_mode = mode;
+    current_divider = divider;
+}
+
+unsigned char spi_submit(struct spi_transaction *transaction)
+{
+    unsigned char next = (queue_tail + 1) & (SPI_QUEUE_SIZE - 1);
+
+    if(next == queue_head)
+    {
+        return 0;                                               // Full
+    }
+    transaction->finished = 0;
+    queue[queue_tail] = transaction;
+    queue_tail = next;                                          // Only now can the ISR see it
+
+    _BIC_SR(GIE);                                               // The ISR must not start one too
+    if(active == 0)
+    {
+        spi_start_next();
+    }
+    _BIS_SR(GIE);
+    return 1;
+}
+
+void spi_wait(struct spi_transaction *transaction)
+{
+    _BIC_SR(GIE);                                               // So the ISR can not finish between
+    while(!transaction->finished)                               // the check and going to sleep
+    {
+        _BIS_SR(LPM0_bits | GIE);                               // The DMA ISR wakes us
+        _BIC_SR(GIE);
+    }
+    _BIS_SR(GIE);
+}
+
+void spi_start_next(void)
+{
+    struct spi_transaction *transaction;
+    const struct spi_device *device;
+
+    if(queue_head == queue_tail)
+    {
+        active = 0;                                             // Nothing waiting
+        return;
+    }
+    transaction = queue[queue_head];
+    queue_head = (queue_head + 1) & (SPI_QUEUE_SIZE - 1);
+    active = transaction;
+    device = &devices[transaction->device];
+
+    if((device->mode != current_mode) || (device->divider != current_divider))
+    {
+        spi_configure(device->mode, device->divider);
+    }
+    *device->cs_out = *device->cs_out & ~device->cs_bit;        // Select the device
+
+    // Channel 0 - UCB0RXBUF to the receive buffer
+    __data20_write_long((unsigned long)&DMA0SA, (unsigned long)&UCB0RXBUF);
+    if(transaction->rx)
+    {
+        __data20_write_long((unsigned long)&DMA0DA, (unsigned long)transaction->rx);
+        DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_3 | DMASRCBYTE | DMADSTBYTE | DMAIE;
+    }
+    else
+    {
+        __data20_write_long((unsigned long)&DMA0DA, (unsigned long)&dummy_rx);
+        DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_0 | DMASRCBYTE | DMADSTBYTE | DMAIE;
+    }
+    DMA0SZ = transaction->length;
+
+    // Channel 1 - the send buffer to UCB0TXBUF
+    if(transaction->tx)
+    {
+        __data20_write_long((unsigned long)&DMA1SA, (unsigned long)transaction->tx);
+        DMA1CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASRCBYTE | DMADSTBYTE;
+    }
+    else
+    {
+        __data20_write_long((unsigned long)&DMA1SA, (unsigned long)&idle_byte);
+        DMA1CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_0 | DMASRCBYTE | DMADSTBYTE;
+    }
+    __data20_write_long((unsigned long)&DMA1DA, (unsigned long)&UCB0TXBUF);
+    DMA1SZ = transaction->length;
+
+    UCB0IFG = UCB0IFG & ~(UCRXIFG | UCTXIFG);                   // The DMA starts on a flag going HI...
+    DMA0CTL = DMA0CTL | DMAEN;
+    DMA1CTL = DMA1CTL | DMAEN;
+    UCB0IFG = UCB0IFG | UCTXIFG;                                // ...so make one for the first byte
+}
+
+// ****************************************************
+// Benchmark - one SMCLK setting
+// ****************************************************
+void run_benchmark(unsigned char preset)
+{
+    unsigned int start;
+    unsigned int cycles;
+    unsigned char i;
+
+    select_clock_signals(clock_presets[preset].csctl1);
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;                        // 1 count = 1 SMCLK cycle
+
+    for(i = 0; i < BENCH_TRANSACTIONS; i = i + 1)
+    {
+        bench[i].device = BENCH;
+        bench[i].tx = tx_buffer;
+        bench[i].rx = rx_buffer;
+        bench[i].length = BENCH_SIZE;
+    }
+
+    start = TA1R;
+    for(i = 0; i < BENCH_TRANSACTIONS; i = i + 1)
+    {
+        spi_submit(&bench[i]);
+    }
+    spi_wait(&bench[BENCH_TRANSACTIONS - 1]);                   // They finish in order
+    cycles = TA1R - start;
+    TA1CTL = 0;
+
+    bytes_per_second[preset] = ((unsigned long)BENCH_TRANSACTIONS * BENCH_SIZE *
+                                clock_presets[preset].hz) / cycles;
+    efficiency_percent[preset] = ((unsigned long)BENCH_TRANSACTIONS * BENCH_SIZE * 8 *
+                                  devices[BENCH].divider * 100) / cycles;
+}
+
+// ****************************************************
+// DMA ISR - a transaction has received its last byte
+// ****************************************************
+#pragma vector=DMA_VECTOR
+__interrupt void DMA_ISR(void)
+{
+    const struct spi_device *device;
+
+    switch(__even_in_range(DMAIV, DMAIV_DMA2IFG))
+    {
+        case DMAIV_DMA0IFG:
+        {
+            device = &devices[active->device];
+            *device->cs_out = *device->cs_out | device->cs_bit; // Deselect
+            active->finished = 1;
+            spi_start_next();                                   // No gap before the next one
+            __bic_SR_register_on_exit(LPM0_bits);               // Wake up main()
+            break;
+        }
+    }
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(unsigned int csctl1)
+{
+    if(csctl1 == 0x0048)
+    {
+        FRCTL0 = FRCTLPW | NWAITS_1;    // FRAM needs 1 wait state above 8MHz - set it BEFORE speeding up
+    }
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = csctl1;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+    if(csctl1 != 0x0048)
+    {
+        FRCTL0 = FRCTLPW;               // No wait states needed - remove them AFTER slowing down
+    }
+}
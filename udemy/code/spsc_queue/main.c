@@ -0,0 +1,224 @@
+/*
+ * Passing data from an ISR to main() with the lock-free queue in spsc.h
+ *
+ * Timer0 interrupts every STRESS_PERIOD cycles and PUSHes the next number (0, 1, 2 ...)
+ * into sample_queue. main() takes them out again - sometimes one at a time, sometimes in
+ * batches, sometimes looking at them in place - and checks that every number comes out
+ * once, in order. Interrupts are never turned off, so the ISR often runs right in the
+ * middle of a POP. That is exactly the case the queue has to get right.
+ *
+ * If main() falls behind, the queue fills up. The ISR then counts the number in dropped
+ * and tries the SAME number again next time, so the numbers main() sees must still go up
+ * by exactly one. order_errors counts every time they do not.
+ *
+ * BENCHMARK
+ * ---------
+ * With interrupts off, Timer1 (1 count = 1 cycle at 8MHz) times SPSC_PUSH and SPSC_POP
+ * of one item, and SPSC_PUSH_BATCH / SPSC_POP_BATCH of BATCH_SIZE items. The time taken
+ * to read TA1R twice is taken away. The results are in push_cycles, pop_cycles and
+ * batch_cycles_per_item. What comes out must be what went in - bench_errors counts it
+ * when it is not.
+ */
+
+#include <msp430.h>
+#include "spsc.h"
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define STRESS_PERIOD           400                 // Cycles between pushes (20000 per second)
+#define STRESS_ITEMS            60000               // Numbers checked by the stress test
+#define BATCH_SIZE              8
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void check_order(unsigned int value);
+void run_benchmark(void);
+
+SPSC_QUEUE(sample_queue, unsigned int, 32);         // Declares struct sample_queue
+
+struct sample_queue samples;                        // Timer0 ISR -> main()
+struct sample_queue bench_queue;                    // Only used by the benchmark
+
+unsigned int next_push;                             // Next number the ISR pushes
+unsigned int expected;                              // Next number main() should get
+unsigned long received;
+unsigned int dropped;                               // ISR found the queue full
+unsigned int order_errors;                          // Numbers out of order (must be 0)
+
+unsigned int push_cycles;
+unsigned int pop_cycles;
+unsigned int batch_cycles_per_item;
+unsigned int bench_errors;                          // Benchmark items that came out wrong
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned int batch[BATCH_SIZE];
+    unsigned int popped;
+    unsigned int value;
+    unsigned int i;
+    unsigned char method = 0;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // MCLK = SMCLK = 8MHz
+    run_benchmark();
+
+    SPSC_INIT(samples);
+    TA0CCR0 = STRESS_PERIOD - 1;
+    TA0CTL = SMCLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+    _BIS_SR(GIE);                                   // Never turned off again
+
+    while(received < STRESS_ITEMS)
+    {
+        method = (method + 1) & 3;                  // Take turns using each way of reading
+
+        if(method == 0)                             // One at a time
+        {
+            if(SPSC_POP(samples, value))
+            {
+                check_order(value);
+            }
+        }
+        else if(method == 1)                        // Batch
+        {
+            SPSC_POP_BATCH(samples, batch, BATCH_SIZE, popped);
+            for(i = 0; i < popped; i = i + 1)
+            {
+                check_order(batch[i]);
+            }
+        }
+        else if(method == 2)                        // Zero-copy, everything up to the array end
+        {
+            popped = SPSC_READ_CONTIGUOUS(samples);
+            for(i = 0; i < popped; i = i + 1)
+            {
+                check_order(*SPSC_PEEK(samples, i));
+            }
+            SPSC_RELEASE(samples, popped);
+        }
+        else                                        // Let the queue fill up a bit
+        {
+            __delay_cycles(2000);
+        }
+    }
+    TA0CTL = 0;
+
+    if((order_errors == 0) && (bench_errors == 0))
+    {
+        P9OUT = BIT7;                               // Green - every number in order
+    }
+    else
+    {
+        P1OUT = BIT0;                               // Red
+    }
+
+    while(1);
+}
+
+void check_order(unsigned int value)
+{
+    if(value != expected)
+    {
+        order_errors = order_errors + 1;
+    }
+    expected = value + 1;
+    received = received + 1;
+}
+
+// ****************************************************
+// Benchmark - interrupts are still off here
+// ****************************************************
+void run_benchmark(void)
+{
+    unsigned int batch[BATCH_SIZE];
+    unsigned int back[BATCH_SIZE];
+    unsigned int start;
+    unsigned int overhead;
+    unsigned int pushed;
+    unsigned int popped;
+    unsigned int value = 0;
+    unsigned int i;
+
+    SPSC_INIT(bench_queue);
+    for(i = 0; i < BATCH_SIZE; i = i + 1)
+    {
+        batch[i] = 100 + i;
+    }
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    start = TA1R;
+    overhead = TA1R - start;                        // Cost of reading the timer
+
+    start = TA1R;
+    SPSC_PUSH(bench_queue, 1234);
+    push_cycles = TA1R - start - overhead;
+
+    start = TA1R;
+    SPSC_POP(bench_queue, value);
+    pop_cycles = TA1R - start - overhead;
+
+    start = TA1R;
+    SPSC_PUSH_BATCH(bench_queue, batch, BATCH_SIZE, pushed);
+    SPSC_POP_BATCH(bench_queue, back, BATCH_SIZE, popped);
+    batch_cycles_per_item = (TA1R - start - overhead) / (2 * BATCH_SIZE);
+
+    TA1CTL = 0;
+
+    bench_errors = 0;
+    if(value != 1234)
+    {
+        bench_errors = bench_errors + 1;
+    }
+    if((pushed != BATCH_SIZE) || (popped != BATCH_SIZE))
+    {
+        bench_errors = bench_errors + 1;
+    }
+    for(i = 0; i < popped; i = i + 1)
+    {
+        if(back[i] != batch[i])
+        {
+            bench_errors = bench_errors + 1;
+        }
+    }
+}
+
+// ****************************************************
+// Timer0 ISR - the producer
+// ****************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    if(SPSC_PUSH(samples, next_push))
+    {
+        next_push = next_push + 1;
+    }
+    else
+    {
+        dropped = dropped + 1;                      // Try the same number next time
+    }
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
@@ -0,0 +1,119 @@
+/*
+ * spsc.h - a queue for passing data from ONE ISR to main() (or from main() to ONE ISR)
+ *          without turning interrupts off
+ *
+ * Up to now the ISRs do their work themselves (UART_ISR changes P1OUT) or keep it in
+ * static variables that main() can not safely look at. A queue lets the ISR hand the
+ * data over and get out quickly, while main() works on it later.
+ *
+ * The queue is "single producer, single consumer" (SPSC): only one side ever PUSHes and
+ * only one side ever POPs. Then no locks are needed, because
+ *
+ *  - head (where the next item goes) is only ever changed by the producer
+ *  - tail (where the next item comes from) is only ever changed by the consumer
+ *  - head and tail are 16-bit, so the MSP430 reads or writes each one in ONE instruction
+ *    and an interrupt can never see half of a change
+ *  - the item is written BEFORE head is moved past it, and read BEFORE tail is moved,
+ *    so the other side never sees a place that is only half filled (or half emptied).
+ *    The items are volatile so the compiler can not move them past head and tail.
+ *
+ * head and tail just keep counting (and roll over from 65535 to 0). The place in the
+ * array is (head & (size - 1)), and the number of items waiting is (head - tail). This
+ * only works if the size is a power of 2 (2, 4, 8 ... 32768) - SPSC_INIT will not
+ * compile if it is not. It also means all "size" places can be used.
+ *
+ *      SPSC_QUEUE(byte_queue, unsigned char, 16);      // struct byte_queue
+ *      struct byte_queue rx_queue;
+ *
+ *      SPSC_INIT(rx_queue);
+ *      SPSC_PUSH(rx_queue, UCA1RXBUF)                  // In the ISR, 0 if it was full
+ *      SPSC_POP(rx_queue, c)                           // In main(), 0 if it was empty
+ *
+ * Batches move several items but change head or tail only once:
+ *
+ *      SPSC_PUSH_BATCH(queue, source, n, pushed);      // pushed = how many fitted
+ *      SPSC_POP_BATCH(queue, destination, n, popped);  // popped = how many there were
+ *
+ * Zero-copy - work on an item where it is in the queue instead of copying it:
+ *
+ *      SPSC_WRITE_SLOT(q) ... SPSC_COMMIT(q, 1)        // Fill the next free place, then add it
+ *      SPSC_PEEK(q, i)    ... SPSC_RELEASE(q, n)       // Look at item i (0 = oldest), then remove n
+ *
+ * SPSC_WRITE_CONTIGUOUS and SPSC_READ_CONTIGUOUS say how many places can be used before
+ * the end of the array, for handing a block of the queue to the DMA.
+ */
+
+#ifndef SPSC_H_
+#define SPSC_H_
+
+// Declares struct name, a queue of size items of type
+#define SPSC_QUEUE(name, type, size)                                                    \
+    struct name                                                                         \
+    {                                                                                   \
+        volatile unsigned int head;                 /* Producer only */                 \
+        volatile unsigned int tail;                 /* Consumer only */                 \
+        volatile type items[size];                                                      \
+    }
+
+#define SPSC_SIZE(q)                    (sizeof((q).items) / sizeof((q).items[0]))
+#define SPSC_MASK(q)                    (SPSC_SIZE(q) - 1)
+#define SPSC_POWER_OF_2(q)              ((void)sizeof(char[(SPSC_SIZE(q) & SPSC_MASK(q)) == 0 ? 1 : -1]))
+#define SPSC_INIT(q)                    (SPSC_POWER_OF_2(q), (q).head = 0, (q).tail = 0)
+
+#define SPSC_COUNT(q)                   ((unsigned int)((q).head - (q).tail))
+#define SPSC_FREE(q)                    ((unsigned int)(SPSC_SIZE(q) - SPSC_COUNT(q)))
+#define SPSC_EMPTY(q)                   ((q).head == (q).tail)
+#define SPSC_FULL(q)                    (SPSC_COUNT(q) == SPSC_SIZE(q))
+
+// Producer side
+#define SPSC_WRITE_SLOT(q)              (&(q).items[(q).head & SPSC_MASK(q)])
+#define SPSC_COMMIT(q, n)               ((q).head = (q).head + (n))
+#define SPSC_PUSH(q, value)             (SPSC_FULL(q) ? 0 :                             \
+                                         (*SPSC_WRITE_SLOT(q) = (value), SPSC_COMMIT(q, 1), 1))
+#define SPSC_WRITE_CONTIGUOUS(q)        ((SPSC_SIZE(q) - ((q).head & SPSC_MASK(q))) < SPSC_FREE(q) ? \
+                                         (SPSC_SIZE(q) - ((q).head & SPSC_MASK(q))) : SPSC_FREE(q))
+
+// Consumer side
+#define SPSC_PEEK(q, i)                 (&(q).items[((q).tail + (i)) & SPSC_MASK(q)])
+#define SPSC_RELEASE(q, n)              ((q).tail = (q).tail + (n))
+#define SPSC_POP(q, destination)        (SPSC_EMPTY(q) ? 0 :                            \
+                                         ((destination) = *SPSC_PEEK(q, 0), SPSC_RELEASE(q, 1), 1))
+#define SPSC_READ_CONTIGUOUS(q)         ((SPSC_SIZE(q) - ((q).tail & SPSC_MASK(q))) < SPSC_COUNT(q) ? \
+                                         (SPSC_SIZE(q) - ((q).tail & SPSC_MASK(q))) : SPSC_COUNT(q))
+
+// Batches - head or tail is changed once, after all the items
+#define SPSC_PUSH_BATCH(q, source, n, pushed)                                           \
+    do                                                                                  \
+    {                                                                                   \
+        unsigned int spsc_i_;                                                           \
+        unsigned int spsc_head_ = (q).head;                                             \
+        (pushed) = SPSC_FREE(q);                                                        \
+        if((pushed) > (n))                                                              \
+        {                                                                               \
+            (pushed) = (n);                                                             \
+        }                                                                               \
+        for(spsc_i_ = 0; spsc_i_ < (pushed); spsc_i_ = spsc_i_ + 1)                     \
+        {                                                                               \
+            (q).items[(spsc_head_ + spsc_i_) & SPSC_MASK(q)] = (source)[spsc_i_];       \
+        }                                                                               \
+        (q).head = spsc_head_ + (pushed);                                               \
+    } while(0)
+
+#define SPSC_POP_BATCH(q, destination, n, popped)                                       \
+    do                                                                                  \
+    {                                                                                   \
+        unsigned int spsc_i_;                                                           \
+        unsigned int spsc_tail_ = (q).tail;                                             \
+        (popped) = SPSC_COUNT(q);                                                       \
+        if((popped) > (n))                                                              \
+        {                                                                               \
+            (popped) = (n);                                                             \
+        }                                                                               \
+        for(spsc_i_ = 0; spsc_i_ < (popped); spsc_i_ = spsc_i_ + 1)                     \
+        {                                                                               \
+            (destination)[spsc_i_] = (q).items[(spsc_tail_ + spsc_i_) & SPSC_MASK(q)];  \
+        }                                                                               \
+        (q).tail = spsc_tail_ + (popped);                                               \
+    } while(0)
+
+#endif /* SPSC_H_ */
@@ -0,0 +1,325 @@
+/*
+ * Measuring the frequency and pulse width of a signal with Timer_A CAPTURE mode
+ *
+ * All the other timer programs use COMPARE mode: we load TAxCCRn and the timer tells
+ * us when TAxR gets there. In CAPTURE mode it is the other way around - when the signal
+ * on the capture pin changes, the timer hardware copies TAxR into TAxCCRn for us. The
+ * CPU does not have to watch the pin at all, it only has to read the time afterwards.
+ *
+ * Setup used here:
+ *  - Timer1 counts SMCLK (8MHz, 125ns per count) in CONTINUOUS mode
+ *  - P1.2 is TA1.CCI1A, the capture input for TA1CCR1
+ *  - TA1CCTL1 captures on ONE edge at a time, synchronised to the timer clock (SCS).
+ *    It starts on the rising edge (CM_1), and the ISR flips it to the falling edge (CM_2)
+ *    and back each time. So the ISR always knows which edge it was from what it asked
+ *    for - reading the pin (CCI) would be too late, as near the fastest signal the pin
+ *    has already changed again by then.
+ *
+ * Timer1 only counts to 65535 (8.192ms), so every time it rolls over the TAIFG
+ * interrupt adds one to overflows. The overflow count and the captured value together
+ * make a 32-bit time, so signals as slow as several minutes can be measured.
+ *
+ * Each time the signal goes HI we know the period (rise to rise) and the time it was HI
+ * (rise to fall). If the next edge came before the ISR flipped CM (the pin is already on
+ * the other side and nothing was captured) or a capture was overwritten (COV), the edge
+ * is counted in missed_edges and the period it was in is thrown away. The ISR only adds these up, which takes the same number of cycles
+ * every time. After AVERAGE_COUNT periods the averages are put in the mailbox.
+ *
+ * MAILBOX
+ * -------
+ * main() can not stop the ISR writing in the middle of a read, so instead of turning
+ * interrupts off we use a "sequence" number. The ISR adds one before and after it
+ * writes, so the sequence is odd while the data is changing. main() reads the sequence,
+ * copies the data, and reads the sequence again - if it changed or is odd, it reads
+ * again.
+ *
+ * SELF TEST
+ * ---------
+ * Connect P1.0 to P1.2 with a jumper wire. Timer0 makes a PWM signal on P1.0 (TA0.1)
+ * from the same 8MHz SMCLK, stepping through the test_signals[] table every second.
+ * For each one, the difference between what we made and what we measured is kept in
+ * period_error[] and high_error[], and the edges lost in missed_in_test[]. The worst
+ * number of cycles from the edge to the end of the capture work is kept in
+ * isr_worst_cycles. Both edges need to be handled before the next one, so the fastest
+ * signal we can measure is about 8MHz / (2 * isr_worst_cycles).
+ *
+ * The last test (LIMIT_TEST) checks that claim: after the table, a 50% signal with a
+ * period of 2 * isr_worst_cycles plus 1/8 (limit_period) is made, as fast as the ISR
+ * should be able to follow. Its errors and missed edges go in the same arrays.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define ONE_SECOND              40000               // 40000 * 25us = 1 sec
+#define AVERAGE_COUNT           8                   // Periods averaged (must be a power of 2)
+#define AVERAGE_SHIFT           3                   // 2^3 = 8
+#define NUMBER_OF_SIGNALS       5
+#define LIMIT_TEST              NUMBER_OF_SIGNALS   // After the table - near the fastest
+#define NUMBER_OF_TESTS         (NUMBER_OF_SIGNALS + 1)
+
+struct capture_result
+{
+    unsigned long period;                           // Average rise to rise, in SMCLK counts
+    unsigned long high_time;                        // Average rise to fall, in SMCLK counts
+};
+
+// Test signals made by Timer0 - period and HI time in SMCLK counts
+const unsigned int test_signals[NUMBER_OF_SIGNALS][2] =
+{
+    {40000, 10000},                                 // 200Hz,  25% duty cycle
+    { 8000,  4000},                                 // 1kHz,   50%
+    { 1000,   750},                                 // 8kHz,   75%
+    {  400,   100},                                 // 20kHz,  25%
+    {  200,   100}                                  // 40kHz,  50%
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                                // Assigns uC clock signals
+void start_capture(void);                                       // Timer1 capture on P1.2
+void make_test_signal(unsigned int period, unsigned int high); // Timer0 PWM on P1.0
+void read_mailbox(struct capture_result *result);               // Safe copy of the latest averages
+
+volatile unsigned int overflows;                                // Timer1 roll-overs (upper 16 bits)
+volatile unsigned int mailbox_sequence;                         // Odd while the ISR is writing
+volatile struct capture_result mailbox;                         // Latest averages from the ISR
+volatile unsigned int missed_edges;                             // Capture OVerflows (edge came too soon)
+volatile unsigned int isr_worst_cycles;                         // Edge to end of ISR, worst case
+
+unsigned long last_rise;                                        // 32-bit times used by the ISR
+unsigned long last_fall;
+unsigned long sum_period;
+unsigned long sum_high;
+unsigned char periods;
+unsigned char have_rise;                                        // 0 until the first rising edge
+
+long period_error[NUMBER_OF_TESTS];                             // Measured - expected (self test)
+long high_error[NUMBER_OF_TESTS];
+unsigned int missed_in_test[NUMBER_OF_TESTS];
+unsigned int limit_period;                                      // LIMIT_TEST, in SMCLK counts
+unsigned int test_period;                                       // Signal being made
+unsigned int test_high;
+unsigned char signal;                                           // Test being done
+volatile unsigned char next_signal;                             // Set by Timer2 every second
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    struct capture_result result;
+    unsigned int missed_at_start;
+
+    WDTCTL = WDTPW | WDTHOLD;                                   // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                                      // Enable inputs and outputs
+
+    select_clock_signals();                                     // SMCLK = 8MHz
+    start_capture();
+
+    signal = 0;
+    make_test_signal(test_signals[0][0], test_signals[0][1]);
+    missed_at_start = 0;
+
+    TA2CCR0 = ONE_SECOND;                                       // Next test signal every second
+    TA2CTL = ACLK | UP | TACLR;
+    TA2CCTL0 = CCIE;
+
+    _BIS_SR(GIE);
+
+    while(1)
+    {
+        _BIS_SR(LPM0_bits | GIE);                               // Timer2 wakes us every second
+
+        if(next_signal)
+        {
+            next_signal = 0;
+            read_mailbox(&result);
+            period_error[signal] = (long)result.period - test_period;
+            high_error[signal] = (long)result.high_time - test_high;
+            missed_in_test[signal] = missed_edges - missed_at_start;
+
+            signal = signal + 1;
+            if(signal == NUMBER_OF_TESTS)
+            {
+                signal = 0;
+            }
+            if(signal == LIMIT_TEST)                            // 2 edges per period, 1/8 to spare
+            {
+                limit_period = 2 * isr_worst_cycles + isr_worst_cycles / 4;
+                make_test_signal(limit_period, limit_period / 2);
+            }
+            else
+            {
+                make_test_signal(test_signals[signal][0], test_signals[signal][1]);
+            }
+            missed_at_start = missed_edges;
+        }
+    }
+}
+
+// *******************************
+// Capture set up
+// *******************************
+void start_capture(void)
+{
+    P1DIR = P1DIR & ~BIT2;                                      // P1.2 is an input...
+    P1SEL1 = P1SEL1 & ~BIT2;
+    P1SEL0 = P1SEL0 | BIT2;                                     // ...connected to TA1.CCI1A
+
+    overflows = 0;
+    have_rise = 0;
+    periods = 0;
+    sum_period = 0;
+    sum_high = 0;
+
+    TA1CCTL1 = CM_1 | CCIS_0 | SCS | CAP | CCIE;                // Rising edge first, CCI1A, synchronous
+    TA1CTL = SMCLK | CONTINUOUS | TACLR | TAIE;                 // TAIE - interrupt on every roll-over
+}
+
+void make_test_signal(unsigned int period, unsigned int high)
+{
+    test_period = period;
+    test_high = high;
+
+    P1DIR = P1DIR | BIT0;                                       // P1.0 is an output...
+    P1SEL1 = P1SEL1 & ~BIT0;
+    P1SEL0 = P1SEL0 | BIT0;                                     // ...driven by TA0.1
+
+    TA0CTL = 0;                                                 // Stop while we change it
+    TA0CCR0 = period - 1;                                       // UP mode counts 0 to CCR0, so -1
+    TA0CCR1 = high;                                             // HI for this many counts
+    TA0CCTL1 = OUTMOD_7;                                        // Reset/Set: HI at 0, LO at TA0CCR1
+    TA0CTL = SMCLK | UP | TACLR;
+}
+
+// *******************************
+// Mailbox read (main side)
+// *******************************
+void read_mailbox(struct capture_result *result)
+{
+    unsigned int sequence;
+
+    do
+    {
+        sequence = mailbox_sequence;
+        *result = mailbox;
+    } while((sequence & 1) || (sequence != mailbox_sequence));  // ISR wrote during our copy - try again
+}
+
+// ****************************************************
+// Timer1 ISR - capture on P1.2 and roll-over counter
+// ****************************************************
+#pragma vector=TIMER1_A1_VECTOR
+__interrupt void Timer1_Capture_ISR(void)
+{
+    unsigned int captured;
+    unsigned int high_word;
+    unsigned long now;
+    unsigned char rising;
+    unsigned char lost = 0;
+
+    switch(__even_in_range(TA1IV, TA1IV_TAIFG))
+    {
+        case TA1IV_TACCR1:                                      // Signal changed
+        {
+            captured = TA1CCR1;
+            rising = ((TA1CCTL1 & CM_3) == CM_1);               // The edge we asked for
+            TA1CCTL1 = TA1CCTL1 ^ CM_3;                         // CM_1 <-> CM_2 - the other edge next
+            high_word = overflows;
+
+            // The roll-over has lower priority than CCR1. If it is waiting and the captured
+            // value is small, the timer rolled over BEFORE the edge, so count it now.
+            if((TA1CTL & TAIFG) && (captured < 0x8000))
+            {
+                high_word = high_word + 1;
+            }
+            now = ((unsigned long)high_word << 16) | captured;
+
+            if(TA1CCTL1 & COV)                                  // A capture was overwritten
+            {
+                TA1CCTL1 = TA1CCTL1 & ~COV;
+                lost = 1;
+            }
+            if(!(TA1CCTL1 & CCIFG) && (((TA1CCTL1 & CCI) != 0) != rising))
+            {
+                lost = 1;                                       // The pin changed back before CM did,
+            }                                                   // so the next capture is a period late
+            if(lost)
+            {
+                missed_edges = missed_edges + 1;
+                have_rise = 0;                                  // No period from this edge...
+            }
+
+            if(rising)
+            {
+                if(have_rise)
+                {
+                    sum_period = sum_period + (now - last_rise);
+                    sum_high = sum_high + (last_fall - last_rise);
+                    periods = periods + 1;
+
+                    if(periods == AVERAGE_COUNT)
+                    {
+                        mailbox_sequence = mailbox_sequence + 1; // Odd - main() must not trust the data
+                        mailbox.period = sum_period >> AVERAGE_SHIFT;
+                        mailbox.high_time = sum_high >> AVERAGE_SHIFT;
+                        mailbox_sequence = mailbox_sequence + 1; // Even - data is complete
+                        sum_period = 0;
+                        sum_high = 0;
+                        periods = 0;
+                    }
+                }
+                last_rise = now;
+                have_rise = 1;
+            }
+            else                                                // Falling edge
+            {
+                last_fall = now;
+            }
+            if(lost)
+            {
+                have_rise = 0;                                  // ...or from the next rise
+            }
+
+            captured = TA1R - captured;                         // Cycles since the edge
+            if(captured > isr_worst_cycles)
+            {
+                isr_worst_cycles = captured;
+            }
+            break;
+        }
+
+        case TA1IV_TAIFG:                                       // Timer1 rolled over
+        {
+            overflows = overflows + 1;
+            break;
+        }
+    }
+}
+
+// ****************************************************
+// Timer2 ISR - one second per test signal
+// ****************************************************
+#pragma vector=TIMER2_A0_VECTOR
+__interrupt void Timer2_ISR(void)
+{
+    next_signal = 1;
+    __bic_SR_register_on_exit(LPM0_bits);                       // Wake up main()
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
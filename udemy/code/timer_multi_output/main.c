@@ -0,0 +1,285 @@
+/*
+ * Many blinking outputs from ONE timer
+ *
+ * two_timers_isr and two_timers_simple use Timer0 AND Timer1 just to blink two LEDs at
+ * different speeds. With more outputs we would run out of timers. Here one timer does
+ * them all:
+ *
+ *  - Timer0 counts ACLK in CONTINUOUS mode and is never reset
+ *  - Each output has a toggle interval (half its period) and the time of its next edge
+ *  - TA0CCR1 is always set to the NEAREST next edge of the P1 outputs, and TA0CCR2 to
+ *    the nearest edge of the P9 outputs. Each CCR and its port is a "lane".
+ *  - When a lane's CCR is reached, every output of that lane with an edge due is added
+ *    to one mask, and the port is changed with ONE write (P1OUT ^= mask), so outputs
+ *    with edges at the same time switch together. Then the CCR is moved on to the next
+ *    nearest edge.
+ *
+ * Edge times are kept as 32-bit counts, so intervals can be longer than 65535. If the
+ * next edge is too far away, the CCR is set MAX_STEP ahead and nothing is toggled then.
+ *
+ * If the ISR was held up (or two edges are only a count or two apart), Timer0 may
+ * already be past the new CCR value when it is written. The match would then not come
+ * until Timer0 goes all the way round (65536 counts, 1.6s). So after writing the CCR,
+ * service_lane() checks TA0R, and if the edge has already passed it clears the flag and
+ * does that edge straight away (it is counted in worst_error as late).
+ *
+ * Outputs are added with add_output(lane, bit, interval, phase). phase is the time of
+ * the first edge, so two outputs with the same interval can be shifted against each
+ * other.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * Connect a scope or logic analyser to the extra pins to see the waveforms.
+ *  - worst_error is the most Timer0 counts any edge was late (TA0R when the port was
+ *    written, minus the CCR value). caught_up counts the edges that had already passed
+ *    when their CCR was written.
+ *  - After TEST_SECONDS, schedule_errors counts outputs whose number of toggles is not
+ *    what the intervals and phases say it should be
+ *  - isr_count is how many times the lane ISR ran. toggles_total is how many ISRs a
+ *    timer-per-output design would have needed (one for every edge), using
+ *    NUMBER_OF_OUTPUTS timers instead of one.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define ONE_SECOND              40000UL             // 40000 * 25us = 1 sec
+#define MAX_STEP                0x8000              // Longest CCR jump
+#define LANES                   2                   // TA0CCR1 and TA0CCR2
+#define MAX_OUTPUTS             4                   // Per lane
+#define NUMBER_OF_OUTPUTS       6                   // Added in main()
+#define TEST_SECONDS            10
+
+struct output
+{
+    unsigned char bit;                              // Pin on the lane's port
+    unsigned long interval;                         // Counts between edges (half the period)
+    unsigned long phase;                            // Time of the first edge
+    unsigned long next;                             // Time of the next edge
+    unsigned int toggles;
+};
+
+struct lane
+{
+    volatile unsigned char *port_out;               // PxOUT for every output of this lane
+    volatile unsigned int *ccr;                     // TA0CCR1 or TA0CCR2
+    volatile unsigned int *cctl;                    // TA0CCTL1 or TA0CCTL2
+    unsigned long now;                              // 32-bit time of the last CCR match
+    unsigned int last_ccr;
+    unsigned char count;
+    struct output outputs[MAX_OUTPUTS];
+};
+
+// ********************
+// Function Definitions
+// ********************
+void add_output(unsigned char lane, unsigned char bit, unsigned long interval, unsigned long phase);
+void start_lanes(void);
+void service_lane(struct lane *l);                  // Called by the ISR
+
+struct lane lanes[LANES];
+
+volatile unsigned long isr_count;
+unsigned long toggles_total;
+unsigned int worst_error;                           // Timer0 counts
+unsigned int caught_up;                             // Next edge already passed - done at once
+unsigned char schedule_errors;
+volatile unsigned int seconds;                      // TA0CCR0 counts these
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char n;
+    unsigned char i;
+    unsigned long expected;
+    struct output *o;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    lanes[0].port_out = &P1OUT;
+    lanes[0].ccr = &TA0CCR1;
+    lanes[0].cctl = &TA0CCTL1;
+    lanes[1].port_out = &P9OUT;
+    lanes[1].ccr = &TA0CCR2;
+    lanes[1].cctl = &TA0CCTL2;
+
+    //         lane  pin   interval                phase
+    add_output(0,    BIT0, ONE_SECOND / 2,         ONE_SECOND / 2);    // Red LED, 1Hz
+    add_output(0,    BIT3, ONE_SECOND / 8,         ONE_SECOND / 8);    // 4Hz, edges line up with the LED
+    add_output(0,    BIT4, ONE_SECOND / 8,         ONE_SECOND / 16);   // 4Hz, a quarter period later
+    add_output(1,    BIT7, ONE_SECOND,             ONE_SECOND);        // Green LED, 0.5Hz
+    add_output(1,    BIT5, ONE_SECOND / 3,         1000);              // 1.5Hz
+    add_output(1,    BIT6, 5 * ONE_SECOND,         ONE_SECOND / 4);    // 0.1Hz, longer than 65535
+
+    start_lanes();
+
+    TA0CCR0 = ONE_SECOND;                           // Seconds for the test
+    TA0CCTL0 = CCIE;
+
+    while(seconds < TEST_SECONDS)
+    {
+        _BIS_SR(LPM3_bits | GIE);                   // The ISRs do everything
+    }
+
+    _BIC_SR(GIE);                                   // Look at the counts all at once
+    toggles_total = 0;
+    for(n = 0; n < LANES; n = n + 1)
+    {
+        for(i = 0; i < lanes[n].count; i = i + 1)
+        {
+            o = &lanes[n].outputs[i];
+            expected = 0;
+            if(lanes[n].now >= o->phase)
+            {
+                expected = (lanes[n].now - o->phase) / o->interval + 1;
+            }
+            if(o->toggles != expected)
+            {
+                schedule_errors = schedule_errors + 1;
+            }
+            toggles_total = toggles_total + o->toggles;
+        }
+    }
+    _BIS_SR(GIE);
+
+    while(1)
+    {
+        _BIS_SR(LPM3_bits | GIE);                   // Keep blinking
+    }
+}
+
+// ******************************
+// Scheduler set up
+// ******************************
+void add_output(unsigned char lane, unsigned char bit, unsigned long interval, unsigned long phase)
+{
+    struct lane *l = &lanes[lane];
+    struct output *o = &l->outputs[l->count];
+
+    o->bit = bit;
+    o->interval = interval;
+    o->phase = phase;
+    o->next = phase;
+    o->toggles = 0;
+    l->count = l->count + 1;
+
+    if(lane == 0)                                   // Output, starting LO
+    {
+        P1DIR = P1DIR | bit;
+        P1OUT = P1OUT & ~bit;
+    }
+    else
+    {
+        P9DIR = P9DIR | bit;
+        P9OUT = P9OUT & ~bit;
+    }
+}
+
+void start_lanes(void)
+{
+    unsigned char n;
+
+    TA0CTL = ACLK | CONTINUOUS | TACLR;             // Time 0 for every lane
+
+    for(n = 0; n < LANES; n = n + 1)
+    {
+        lanes[n].now = 0;
+        lanes[n].last_ccr = 0;
+        *lanes[n].ccr = 0;
+        service_lane(&lanes[n]);                    // Finds the first edge, sets the CCR
+    }
+    TA0CCTL1 = CCIE;
+    TA0CCTL2 = CCIE;
+}
+
+// ******************************
+// One lane - toggle what is due, find the next edge
+// ******************************
+void service_lane(struct lane *l)
+{
+    unsigned char mask;
+    unsigned long nearest;
+    unsigned long wait;
+    unsigned int late;
+    unsigned char i;
+    struct output *o;
+
+    while(1)
+    {
+        l->now = l->now + (unsigned int)(*l->ccr - l->last_ccr);
+        l->last_ccr = *l->ccr;
+        mask = 0;
+        nearest = MAX_STEP;
+
+        for(i = 0; i < l->count; i = i + 1)
+        {
+            o = &l->outputs[i];
+            if(o->next == l->now)                   // Edge due now
+            {
+                mask = mask | o->bit;
+                o->next = o->next + o->interval;
+                o->toggles = o->toggles + 1;
+            }
+            wait = o->next - l->now;
+            if(wait < nearest)
+            {
+                nearest = wait;
+            }
+        }
+
+        if(mask)
+        {
+            *l->port_out = *l->port_out ^ mask;     // Every edge of this tick, one write
+            late = TA0R - l->last_ccr;
+            if(late > worst_error)
+            {
+                worst_error = late;
+            }
+        }
+
+        *l->ccr = l->last_ccr + (unsigned int)nearest;
+        if((unsigned int)(TA0R - l->last_ccr) < (unsigned int)nearest)
+        {
+            return;                                 // Still ahead of Timer0 - the match will come
+        }
+        *l->cctl = *l->cctl & ~CCIFG;               // Already passed - do it now, not 65536 later
+        caught_up = caught_up + 1;
+    }
+}
+
+// ******************************
+// Timer0 ISRs
+// ******************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_Seconds_ISR(void)
+{
+    TA0CCR0 = TA0CCR0 + ONE_SECOND;
+    seconds = seconds + 1;
+    __bic_SR_register_on_exit(LPM3_bits);           // Wake up main()
+}
+
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt void Timer0_Lanes_ISR(void)
+{
+    switch(__even_in_range(TA0IV, TA0IV_TAIFG))
+    {
+        case TA0IV_TACCR1:
+        {
+            isr_count = isr_count + 1;
+            service_lane(&lanes[0]);
+            break;
+        }
+
+        case TA0IV_TACCR2:
+        {
+            isr_count = isr_count + 1;
+            service_lane(&lanes[1]);
+            break;
+        }
+    }
+}
@@ -0,0 +1,226 @@
+/*
+ * One clock for everything with ts.h
+ *
+ * Blinks the red LED every BLINK_US with a deadline from ts.h instead of a counter of
+ * timer periods (timer_up_long).
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * Before the blinking starts:
+ *
+ *  - helper_errors - ts_before() and ts_elapsed() are tried on times on both sides of
+ *    the 32-bit wrap (0xFFFFFFF0 and 0x00000010 and so on)
+ *
+ *  - read_errors - for STRESS_SECONDS Timer_B0 runs at 8MHz (TS_125NS), so TB0R rolls
+ *    over every 8.192ms and reads land on roll-overs all the time. main() reads
+ *    ts_now() and ts_now64() as fast as it can; every read must be later than the one
+ *    before, and by less than MAX_STEP. At the same time Timer0 interrupts every
+ *    STRESS_ISR_TICKS and reads the clock for ISR_READ_COUNTS with interrupts OFF, so
+ *    some of its reads happen after a roll-over the ISR has not counted yet (TBIFG).
+ *    reads and isr_reads count how many were checked, isr_pending_reads how many
+ *    of the ISR's reads saw TBIFG waiting.
+ *
+ *  - Timer1 (1 count = 1 cycle at 8MHz) times one ts_now() (now_cycles) and one
+ *    ts_now64() (now64_cycles), with nothing turned off.
+ *
+ * Green LED - all passed. Red LED only blinking - look at the error counts.
+ */
+
+#include <msp430.h>
+#include "ts.h"
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+
+#define STRESS_SECONDS          2
+#define COUNTS_PER_SECOND       8000000UL           // TS_125NS
+#define MAX_STEP                8000                // 1ms at 125ns - longer than any ISR here
+#define STRESS_ISR_TICKS        97                  // 2.4ms, not a multiple of a roll-over
+#define ISR_READ_COUNTS         2400                // 300us of reads with interrupts off
+#define BLINK_US                500000UL
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void test_helpers(void);
+void stress_reads(void);
+void run_benchmark(void);
+
+unsigned char helper_errors;
+volatile unsigned long read_errors;
+unsigned long reads;
+volatile unsigned long isr_reads;
+volatile unsigned int isr_pending_reads;
+unsigned int now_cycles;
+unsigned int now64_cycles;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned long deadline;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+
+    test_helpers();
+    ts_init(TS_125NS);
+    _BIS_SR(GIE);
+    stress_reads();
+    run_benchmark();
+
+    if((helper_errors == 0) && (read_errors == 0))
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+
+    ts_init(TS_1US);                                // The normal clock from here on
+    deadline = ts_deadline(BLINK_US);
+    while(1)
+    {
+        if(ts_expired(deadline))
+        {
+            P1OUT = P1OUT ^ BIT0;
+            deadline = deadline + BLINK_US;         // From the last deadline - no drift
+        }
+    }
+}
+
+// ****************************************************
+// Elapsed and deadline helpers across the 32-bit wrap
+// ****************************************************
+void test_helpers(void)
+{
+    unsigned long a = 0xFFFFFFF0UL;                 // Just before the wrap
+    unsigned long b = 0x00000010UL;                 // Just after it
+
+    if(!ts_before(a, b) || ts_before(b, a) || ts_before(a, a))
+    {
+        helper_errors = helper_errors + 1;
+    }
+    if((b - a) != 0x20)                             // What ts_elapsed() works out
+    {
+        helper_errors = helper_errors + 1;
+    }
+    if(!ts_before(0x7FFFFFF0UL, 0x80000010UL))      // Half way round
+    {
+        helper_errors = helper_errors + 1;
+    }
+}
+
+// ****************************************************
+// Hammer the clock across thousands of roll-overs
+// ****************************************************
+void stress_reads(void)
+{
+    unsigned long last;
+    unsigned long now;
+    unsigned long long last64;
+    unsigned long long now64;
+    unsigned long end;
+
+    TA0CCR0 = STRESS_ISR_TICKS;
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+
+    last = ts_now();
+    last64 = ts_now64();
+    end = last + STRESS_SECONDS * COUNTS_PER_SECOND;
+
+    while(ts_before(last, end))
+    {
+        now = ts_now();
+        if(!ts_before(last, now) || ((now - last) > MAX_STEP))
+        {
+            read_errors = read_errors + 1;
+        }
+        last = now;
+
+        now64 = ts_now64();
+        if((now64 <= last64) || ((now64 - last64) > MAX_STEP))
+        {
+            read_errors = read_errors + 1;
+        }
+        last64 = now64;
+
+        reads = reads + 2;
+    }
+
+    TA0CCTL0 = 0;
+}
+
+void run_benchmark(void)
+{
+    unsigned int start;
+    unsigned int overhead;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    start = TA1R;
+    overhead = TA1R - start;
+
+    start = TA1R;
+    ts_now();
+    now_cycles = TA1R - start - overhead;
+
+    start = TA1R;
+    ts_now64();
+    now64_cycles = TA1R - start - overhead;
+
+    TA1CTL = 0;
+}
+
+// *************************************************************************
+// Timer0 ISR - reads with interrupts off (stress test only)
+// *************************************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    unsigned long first;
+    unsigned long last;
+    unsigned long now;
+
+    first = ts_now();
+    last = first;
+    do
+    {
+        now = ts_now();
+        if(!ts_before(last, now) && (now != last))  // Going backwards
+        {
+            read_errors = read_errors + 1;
+        }
+        if((now - last) > MAX_STEP)                 // Jumped a whole roll-over
+        {
+            read_errors = read_errors + 1;
+        }
+        if(TB0CTL & TBIFG)
+        {
+            isr_pending_reads = isr_pending_reads + 1;
+        }
+        last = now;
+        isr_reads = isr_reads + 1;
+    } while((last - first) < ISR_READ_COUNTS);
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
@@ -0,0 +1,77 @@
+/*
+ * ts.c - Timer_B0, the roll-over counter and the tear-free reads for ts.h
+ */
+
+#include <msp430.h>
+#include "ts.h"
+
+volatile unsigned long ts_wraps;
+
+void ts_init(unsigned int divider)
+{
+    ts_wraps = 0;
+    TB0CTL = TBSSEL_2 | divider | MC_2 | TBCLR | TBIE; // SMCLK, CONTINUOUS, roll-over interrupt
+}
+
+unsigned long ts_now(void)
+{
+    unsigned int high;
+    unsigned int low;
+    unsigned int pending;
+
+    do
+    {
+        high = *(volatile unsigned int *)&ts_wraps; // Low word only - one read, can not tear
+        low = TB0R;
+        pending = TB0CTL & TBIFG;                   // AFTER TB0R
+    } while(high != *(volatile unsigned int *)&ts_wraps); // The ISR ran in between - again
+
+    if(pending && (low < 0x8000))                   // Rolled over, ISR not run yet
+    {
+        high = high + 1;
+    }
+    return ((unsigned long)high << 16) | low;
+}
+
+unsigned long long ts_now64(void)
+{
+    unsigned long high;
+    unsigned int low;
+    unsigned int pending;
+
+    do
+    {
+        high = ts_wraps;                            // Two reads - if the ISR splits them, it
+        low = TB0R;                                 // also changes ts_wraps before the check
+        pending = TB0CTL & TBIFG;
+    } while(high != ts_wraps);
+
+    if(pending && (low < 0x8000))
+    {
+        high = high + 1;
+    }
+    return ((unsigned long long)high << 16) | low;
+}
+
+void ts_delay(unsigned long counts)
+{
+    unsigned long start = ts_now();
+
+    while(ts_elapsed(start) < counts);
+}
+
+// ****************************************************
+// Timer_B0 roll-over
+// ****************************************************
+#pragma vector=TIMER0_B1_VECTOR
+__interrupt void TS_Wrap_ISR(void)
+{
+    switch(__even_in_range(TB0IV, TB0IV_TBIFG))
+    {
+        case TB0IV_TBIFG:
+        {
+            ts_wraps = ts_wraps + 1;
+            break;
+        }
+    }
+}
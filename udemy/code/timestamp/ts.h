@@ -0,0 +1,61 @@
+/*
+ * ts.h - one clock for the whole program: 32-bit (and 64-bit) time stamps
+ *
+ * timer_up_long counts 50000s in an unsigned char, two_timers_complicated has its own
+ * t0_count and t1_count... each program keeps time its own way and the counters are easy
+ * to overflow. ts.h gives ONE free-running clock:
+ *
+ *      Timer_B0 counts SMCLK / 8 = 1MHz (1us) in CONTINUOUS mode and never stops.
+ *      Every time TB0R rolls over (65.536ms) the ISR adds one to ts_wraps.
+ *
+ *      time = ts_wraps * 65536 + TB0R
+ *
+ * ts_now() gives the time in us as an unsigned long (it wraps after 71.6 minutes),
+ * ts_now64() as an unsigned long long (it never wraps in practice).
+ *
+ * TEAR-FREE WITHOUT TURNING INTERRUPTS OFF
+ * ----------------------------------------
+ * Two things can go wrong when the two halves are read one after the other:
+ *  - the roll-over ISR runs between the reads - ts_wraps is read again afterwards and if
+ *    it changed, we simply read everything again
+ *  - TB0R has rolled over but the ISR has NOT run yet (we are in another ISR, or
+ *    interrupts are off) - TBIFG is still set. If it is and TB0R is small (under 0x8000),
+ *    the roll-over happened before our read of TB0R, so one is added. That test only
+ *    works for the first HALF roll-over after TBIFG is set, so interrupts must not be
+ *    off for 32.768ms (4.096ms with TS_125NS) or more - after that TB0R is no longer
+ *    "small" and the time goes back by 65536 counts.
+ *
+ * ELAPSED TIME AND DEADLINES
+ * --------------------------
+ * Subtracting two unsigned times gives the right answer even across a wrap, as long as
+ * they are less than 2^32 us apart:
+ *
+ *      start = ts_now();  ...  took = ts_elapsed(start);
+ *      deadline = ts_deadline(5000);  while(!ts_expired(deadline)) ...
+ *
+ * Never compare times with < or > directly - 0x00000010 is LATER than 0xFFFFFFF0 if the
+ * clock has wrapped. ts_before(a, b) uses the sign of a - b instead, and is right if the
+ * two times are less than 2^31 us (35 minutes) apart.
+ */
+
+#ifndef TS_H_
+#define TS_H_
+
+#include <msp430.h>
+
+#define TS_1US                  ID_3                // SMCLK / 8 - 1 count = 1us
+#define TS_125NS                ID_0                // SMCLK - 1 count = 125ns (8.192ms per wrap)
+
+extern volatile unsigned long ts_wraps;             // Roll-overs of TB0R
+
+void ts_init(unsigned int divider);                 // TS_1US normally - uses TIMER0_B1_VECTOR
+unsigned long ts_now(void);
+unsigned long long ts_now64(void);
+void ts_delay(unsigned long counts);                // Busy wait
+
+#define ts_elapsed(start)       (ts_now() - (start))
+#define ts_deadline(counts)     (ts_now() + (counts))
+#define ts_before(a, b)         ((long)((a) - (b)) < 0)
+#define ts_expired(deadline)    (!ts_before(ts_now(), (deadline)))
+
+#endif /* TS_H_ */
@@ -0,0 +1,237 @@
+/*
+ * Tracing ISRs with trace.h instead of toggling LEDs
+ *
+ * This is two_timers_isr with a TRACE() in each ISR and in main(). Timer0 and Timer1
+ * toggle the LEDs as before, and each also records which LED it changed and how many
+ * times it has run. Send a 'D' to the UART (P4.3, 9600 baud) and trace_dump() sends the
+ * whole trace back (see trace.h for the format). Send a 'T' and trace_timeline() sends
+ * it as text instead, one event a line with its time in microseconds - a terminal is
+ * enough to read it.
+ *
+ * Set TRACE_ENABLED to 0 in the project's predefined symbols and the same program builds
+ * with no tracing at all - there is nothing to take out by hand.
+ *
+ * BENCHMARK
+ * ---------
+ * Before the timers start, Timer2 (1 count = 1 cycle at 8MHz) times BENCH_EVENTS TRACE()
+ * and TRACE_FROM_MAIN() calls. The results are in cycles_per_event and
+ * cycles_per_main_event. If the CPU did nothing but trace it could record
+ * max_events_per_second events every second.
+ */
+
+#include <msp430.h>
+#include "trace.h"
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                // Value required to use 9600 baud
+#define CLK_MOD                 0x4911              // uC will "clean up" clock signal
+#define CPU_HZ                  8000000             // MCLK after select_clock_signals()
+#define BENCH_EVENTS            64
+
+// Trace event ids
+#define EV_TIMER0               1                   // arg = times Timer0 has run
+#define EV_TIMER1               2                   // arg = times Timer1 has run
+#define EV_MAIN_WAKE            3                   // arg = what woke main()
+#define EV_DUMP                 4
+#define EV_BENCH                5
+#define EV_TIMELINE             6
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void assign_pins_to_uart(void);                     // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                           // UART operates at 9600 bits per second
+void run_benchmark(void);
+
+volatile unsigned char dump_requested;
+volatile unsigned char timeline_requested;
+unsigned char timer0_runs;
+unsigned char timer1_runs;
+
+unsigned int cycles_per_event;
+unsigned int cycles_per_main_event;
+unsigned long max_events_per_second;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    assign_pins_to_uart();
+    use_9600_baud();
+    trace_init();
+
+    run_benchmark();
+
+    TA0CCR0 = 40000;                                // Sets value for Timer_0
+    TA0CTL = ACLK | UP;                             // Set ACLK, UP mode for Timer0
+    TA0CCTL0 = CCIE;                                // Enable interrupts for Timer_0
+
+    TA1CCR0 = 20000;                                // Sets value for Timer_1
+    TA1CTL = ACLK | UP;                             // Set ACLK, UP mode for Timer1
+    TA1CCTL0 = CCIE;                                // Enable interrupts for Timer_1
+
+    UCA0IE = UCRXIE;                                // 'D' asks for a dump, 'T' for a timeline
+
+    while(1)
+    {
+        _BIS_SR(LPM0_bits | GIE);                   // Wait for the UART
+        TRACE_FROM_MAIN(EV_MAIN_WAKE, dump_requested);
+
+        if(dump_requested)
+        {
+            dump_requested = 0;
+            TRACE_FROM_MAIN(EV_DUMP, 0);
+            trace_dump();
+        }
+        if(timeline_requested)
+        {
+            timeline_requested = 0;
+            TRACE_FROM_MAIN(EV_TIMELINE, 0);
+            trace_timeline();
+        }
+    }
+}
+
+// ****************************************************
+// Benchmark - interrupts are off until main() sleeps
+// ****************************************************
+void run_benchmark(void)
+{
+    unsigned int start;
+    unsigned int overhead;
+    int took;                                       // Signed - loop jitter can make it < 0
+    unsigned char i;
+
+    TA2CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    start = TA2R;
+    for(i = 0; i < BENCH_EVENTS; i = i + 1)         // The loop on its own
+    {
+        __no_operation();
+    }
+    overhead = TA2R - start;
+
+    start = TA2R;
+    for(i = 0; i < BENCH_EVENTS; i = i + 1)
+    {
+        __no_operation();
+        TRACE(EV_BENCH, i);
+    }
+    took = (int)(TA2R - start - overhead);
+    if(took < 0)                                    // TRACE_ENABLED 0 - nothing but jitter
+    {
+        took = 0;
+    }
+    cycles_per_event = took / BENCH_EVENTS;
+
+    start = TA2R;
+    for(i = 0; i < BENCH_EVENTS; i = i + 1)
+    {
+        __no_operation();
+        TRACE_FROM_MAIN(EV_BENCH, i);
+    }
+    took = (int)(TA2R - start - overhead);
+    if(took < 0)
+    {
+        took = 0;
+    }
+    cycles_per_main_event = took / BENCH_EVENTS;
+
+    TA2CTL = 0;
+
+    if(cycles_per_event > 0)                        // 0 when TRACE_ENABLED is 0
+    {
+        max_events_per_second = CPU_HZ / cycles_per_event;
+    }
+}
+
+// *************************************************************************
+// Timer0 ISR
+// *************************************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    timer0_runs = timer0_runs + 1;
+    TRACE(EV_TIMER0, timer0_runs);
+    P1OUT = P1OUT ^ BIT0;                           // Toggles red LED
+}
+
+// ************************************************************************
+// Timer1 ISR
+// ***********************************************************************
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void Timer1_ISR(void)
+{
+    timer1_runs = timer1_runs + 1;
+    TRACE(EV_TIMER1, timer1_runs);
+    P9OUT = P9OUT ^ BIT7;                           // Toggles green LED
+}
+
+// ************************************************************************
+// UART ISR - 'D' asks for a dump, 'T' for a timeline
+// ***********************************************************************
+#pragma vector=USCI_A0_VECTOR
+__interrupt void UART_ISR(void)
+{
+    unsigned char c = UCA0RXBUF;
+
+    if(c == 'D')
+    {
+        dump_requested = 1;
+        __bic_SR_register_on_exit(LPM0_bits);       // Wake up main()
+    }
+    else if(c == 'T')
+    {
+        timeline_requested = 1;
+        __bic_SR_register_on_exit(LPM0_bits);
+    }
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
@@ -0,0 +1,157 @@
+/*
+ * trace.c - the FRAM buffer, the time stamp timer and the UART dump for trace.h
+ */
+
+#include <msp430.h>
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#pragma PERSISTENT(trace_buffer)
+struct trace_record trace_buffer[TRACE_RECORDS] = {{0}};
+#pragma PERSISTENT(trace_head)
+unsigned int trace_head = 0;
+
+volatile unsigned int trace_wraps;
+
+static void trace_send(unsigned char data);
+static void trace_send_number(unsigned long value);
+
+void trace_init(void)
+{
+    TB0CTL = TBSSEL_2 | ID_3 | MC_2 | TBCLR | TBIE; // SMCLK / 8 = 1us, CONTINUOUS, roll-over interrupt
+}
+
+void trace_catch_up(unsigned int time)
+{
+    unsigned int wraps;
+    struct trace_record *record;
+
+    if((TB0CTL & TBIFG) && (time < 0x8000))         // Rolled over before time was read...
+    {
+        TB0CTL = TB0CTL & ~TBIFG;                   // ...and the ISR has not run - count it here
+        trace_wraps = trace_wraps + 1;
+    }
+
+    while(trace_wraps != 0)
+    {
+        wraps = trace_wraps;
+        if(wraps > 255)                             // arg is only 8 bits
+        {
+            wraps = 255;
+        }
+        record = &trace_buffer[trace_head];
+        record->time = 0;
+        record->id = TRACE_ID_WRAP;
+        record->arg = wraps;
+        trace_head = (trace_head + 1) & (TRACE_RECORDS - 1);
+        trace_wraps = trace_wraps - wraps;
+    }
+}
+
+void trace_dump(void)
+{
+    unsigned int index;
+    unsigned int count = 0;
+    unsigned int i;
+    struct trace_record record;
+
+    index = trace_head;                             // Oldest record (if the buffer has filled)
+    for(i = 0; i < TRACE_RECORDS; i = i + 1)
+    {
+        if(trace_buffer[i].id != 0)
+        {
+            count = count + 1;
+        }
+    }
+
+    trace_send(TRACE_DUMP_START);
+    trace_send('T');
+    trace_send(count & 0xFF);
+    trace_send(count >> 8);
+
+    for(i = 0; i < TRACE_RECORDS; i = i + 1)
+    {
+        record = trace_buffer[index];               // Copy it - an ISR may write over it
+        index = (index + 1) & (TRACE_RECORDS - 1);
+        if((record.id != 0) && (count > 0))
+        {
+            trace_send(record.id);
+            trace_send(record.arg);
+            trace_send(record.time & 0xFF);
+            trace_send(record.time >> 8);
+            count = count - 1;
+        }
+    }
+}
+
+void trace_timeline(void)
+{
+    unsigned int index = trace_head;                // Oldest record
+    unsigned long offset = 0;
+    unsigned int i;
+    struct trace_record record;
+
+    for(i = 0; i < TRACE_RECORDS; i = i + 1)
+    {
+        record = trace_buffer[index];               // Copy it - an ISR may write over it
+        index = (index + 1) & (TRACE_RECORDS - 1);
+        if(record.id == TRACE_ID_WRAP)
+        {
+            offset = offset + ((unsigned long)record.arg << 16);
+        }
+        else if(record.id != 0)                     // "microseconds id arg"
+        {
+            trace_send_number(offset + record.time);
+            trace_send(' ');
+            trace_send_number(record.id);
+            trace_send(' ');
+            trace_send_number(record.arg);
+            trace_send('\r');
+            trace_send('\n');
+        }
+    }
+}
+
+static void trace_send(unsigned char data)
+{
+    while(!(UCA0IFG & UCTXIFG));                    // Wait for room
+    UCA0TXBUF = data;
+}
+
+static void trace_send_number(unsigned long value)
+{
+    char digits[10];
+    unsigned char count = 0;
+
+    do                                              // Digits from the right
+    {
+        digits[count] = '0' + (value % 10);
+        value = value / 10;
+        count = count + 1;
+    } while(value != 0);
+
+    while(count > 0)
+    {
+        count = count - 1;
+        trace_send(digits[count]);
+    }
+}
+
+// ****************************************************
+// Timer_B0 roll-over - only counted, see trace.h
+// ****************************************************
+#pragma vector=TIMER0_B1_VECTOR
+__interrupt void Trace_Wrap_ISR(void)
+{
+    switch(__even_in_range(TB0IV, TB0IV_TBIFG))
+    {
+        case TB0IV_TBIFG:
+        {
+            trace_wraps = trace_wraps + 1;          // Written by the next TRACE()
+            break;
+        }
+    }
+}
+
+#endif /* TRACE_ENABLED */
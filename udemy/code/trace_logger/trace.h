@@ -0,0 +1,108 @@
+/*
+ * trace.h - recording what happened, and when, in FRAM
+ *
+ * When two ISRs fight (two_timers_isr, isr_challenge_2) toggling LEDs only shows that
+ * something happened. TRACE(id, arg) writes a 4 byte record instead:
+ *
+ *      id      which event (1 to 254, chosen by you)
+ *      arg     any 8-bit value that helps (a counter, a pin state...)
+ *      time    TB0R - Timer_B0 counts SMCLK / 8 = 1us, and never stops
+ *
+ * into trace_buffer[], a circular buffer of TRACE_RECORDS records in FRAM. When it is
+ * full the oldest records are written over. Because it is in FRAM (#pragma PERSISTENT)
+ * the last events are still there after a crash or a reset.
+ *
+ *  - TRACE(id, arg)            in an ISR (interrupts are already off there)
+ *  - TRACE_FROM_MAIN(id, arg)  in main(), turns interrupts off for the few cycles it
+ *                              takes, so an ISR can not take the same record
+ *
+ * If TRACE_ENABLED is 0 (define it before including trace.h, or in the project's
+ * predefined symbols) every TRACE disappears and no FRAM or timer is used.
+ *
+ * DUMP FORMAT
+ * -----------
+ * trace_dump() sends the buffer out of the UART (P4.2, 9600 baud), oldest first:
+ *
+ *      0xA5 | 'T' | count (2 bytes, low first) | count records of id, arg, time low, time high
+ *
+ * Records with id 0 have never been written and are not sent.
+ *
+ * TB0R rolls over every 65.536ms. The roll-over interrupt only counts them in
+ * trace_wraps - a record each time would fill the buffer with 15 of them a second. The
+ * next TRACE() first writes ONE TRACE_ID_WRAP record with the count in arg (and time 0),
+ * then its own record. (If TB0R has rolled over but the interrupt has not run yet,
+ * TRACE() counts that roll-over itself, so the order is always right.) To turn a dump
+ * into a timeline, go through the records in order, add arg * 65536 to an "offset" for
+ * every TRACE_ID_WRAP, and the time of each event in microseconds is offset + time.
+ *
+ * trace_timeline() does exactly that on the uC and sends one line of text for each
+ * event - microseconds from the oldest record, id and arg - for a plain terminal.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <msp430.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED           1                   // 0 - every TRACE() disappears
+#endif
+
+#define TRACE_RECORDS           512                 // Must be a power of 2 (512 * 4 bytes = 2KB)
+#define TRACE_ID_WRAP           0xFF                // TB0R rolled over
+#define TRACE_DUMP_START        0xA5                // First byte of a dump
+
+struct trace_record
+{
+    unsigned char id;                               // 0 - never written
+    unsigned char arg;
+    unsigned int time;                              // TB0R, 1us per count
+};
+
+#if TRACE_ENABLED
+
+extern struct trace_record trace_buffer[TRACE_RECORDS];
+extern unsigned int trace_head;                     // Next record to write
+extern volatile unsigned int trace_wraps;           // Roll-overs not written yet
+
+#define TRACE(event, value)                                                             \
+    do                                                                                  \
+    {                                                                                   \
+        unsigned int trace_t_ = TB0R;                                                   \
+        struct trace_record *trace_r_;                                                  \
+        if((trace_wraps != 0) || (TB0CTL & TBIFG))                                      \
+        {                                                                               \
+            trace_catch_up(trace_t_);           /* The roll-overs go first */           \
+        }                                                                               \
+        trace_r_ = &trace_buffer[trace_head];                                           \
+        trace_r_->time = trace_t_;                                                      \
+        trace_r_->id = (event);                                                         \
+        trace_r_->arg = (value);                                                        \
+        trace_head = (trace_head + 1) & (TRACE_RECORDS - 1);                            \
+    } while(0)
+
+#define TRACE_FROM_MAIN(event, value)                                                   \
+    do                                                                                  \
+    {                                                                                   \
+        unsigned int trace_sr_ = __get_SR_register();                                   \
+        __disable_interrupt();                                                          \
+        TRACE(event, value);                                                            \
+        __bis_SR_register(trace_sr_ & GIE);         /* GIE back the way it was */       \
+    } while(0)
+
+void trace_init(void);                              // Starts Timer_B0 - uses TIMER0_B1_VECTOR
+void trace_catch_up(unsigned int time);             // Only for TRACE() - interrupts must be off
+void trace_dump(void);                              // Whole buffer out of the UART
+void trace_timeline(void);                          // The same, as text with 32-bit times
+
+#else
+
+#define TRACE(event, value)
+#define TRACE_FROM_MAIN(event, value)
+#define trace_init()
+#define trace_dump()
+#define trace_timeline()
+
+#endif /* TRACE_ENABLED */
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,702 @@
+/*
+ * Finding the other side's baud rate, then stepping it up
+ *
+ * use_9600_baud() only works if the other side is ALSO at 9600. Here eUSCI_A0 finds out
+ * what rate the other side (the "peer") is using, and then the two agree to go faster
+ * for as long as the link stays clean.
+ *
+ * AUTOBAUD
+ * --------
+ * The peer keeps sending a hello until we answer: a LIN break (the line LO for more
+ * than 10 bits), the sync character 0x55, and then 'H'. 0x55 is good for measuring
+ * because it is 0 1 0 1 0 1 0 1 0 1 (start bit, 8 bits, stop bit) - every bit changes.
+ *
+ *  1. eUSCI_A0 in UCMODE_3 with UCABDEN. After a break the hardware times the sync
+ *     character itself and puts the answer in UCA0BRW / UCBRF. 'H' is then received at
+ *     the right rate. If it sees no break, or UCSTOE / UCBTOE say the sync or break was
+ *     too long, we move on to...
+ *  2. Timer1 capture. P4.3 (RXD) is jumpered to P1.2 (TA1.CCI1A), and every falling
+ *     edge is captured at 8MHz. 0x55 has a falling edge every 2 bits, and then the 'H'
+ *     start bit 2 bits after the last one. Five evenly spaced falling edges are 8 bits,
+ *     so one bit = (last - first) / 8 counts. This works without a break.
+ *
+ * Either way the answer is snapped to the nearest rate in baud_table[] (it must be
+ * within 1/32), so the exact UCBRS modulation from the table is used. Then we send 'A'.
+ *
+ * NEGOTIATION
+ * -----------
+ * Every command is one byte, answered by the peer:
+ *
+ *      'B' index   ->  'b'     both go to baud_table[index]
+ *      TEST_BYTES  ->  echoed  at the new rate, checked here and there
+ *      'K'         ->  'K'     keep the new rate
+ *      'P'         ->  'p'     are you there?
+ *      'C' + THROUGHPUT_BYTES -> 'c'   throughput test
+ *
+ * If an echo is wrong or late, a byte has UCRXERR (framing, parity, overrun), or the
+ * 'K' does not come back, we stop stepping up. Both sides go back to the last good rate
+ * - the peer when its PEER_REVERT_TICKS timer runs out without a 'K', and we wait a bit
+ * longer than that. If the peer DID get our 'K' and only its answer was lost, a 'P' at
+ * the old rate is not answered, so we try the new rate.
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * The peer is eUSCI_A1 on the same chip (its ISRs act like a gateway, starting at
+ * baud_table[PEER_START]). Jumpers:  P4.2 -> P3.5,  P3.4 -> P4.3,  P4.3 -> P1.2
+ *
+ *  - lin_index: found with UCABDEN. capture_index: the peer stops sending breaks, so the
+ *    Timer1 capture is used. Both must be PEER_START.
+ *  - negotiated_baud is the fastest rate that passed. step_errors[] has the errors seen
+ *    at each rate tried.
+ *  - bytes_per_second_before / _after: THROUGHPUT_BYTES sent at the starting rate and
+ *    at the negotiated rate, timed with ACLK.
+ *  - Green LED: everything passed. Red LED: something did not.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define CPU_HZ                  8000000UL           // SMCLK after select_clock_signals()
+#define TICKS_PER_SECOND        40000UL             // ACLK, 25us per count
+
+#define BAUDS                   7
+#define NO_BAUD                 0xFF
+#define PEER_START              2                   // The peer starts at 38400
+#define SYNC                    0x55
+
+#define HELLO_TICKS             4000                // Peer says hello every 100ms
+#define LIN_TICKS               12000               // 300ms of UCABDEN before the capture
+#define CAPTURE_TICKS           12000
+#define REPLY_TICKS             400                 // 10ms for an answer
+#define GUARD_TICKS             40                  // 1ms for both to change rate
+#define PEER_REVERT_TICKS       2000                // 50ms with no 'K' - peer goes back
+#define TEST_BYTES              32
+#define THROUGHPUT_BYTES        1024
+
+#define METHOD_NONE             0
+#define METHOD_LIN              1                   // UCABDEN
+#define METHOD_CAPTURE          2                   // Timer1 on the RX pin
+
+struct baud_setting
+{
+    unsigned long baud;
+    unsigned int brw;                               // UCAxBRW
+    unsigned int mctlw;                             // UCAxMCTLW - UCBRS, UCBRF, UCOS16
+};
+
+// 8MHz SMCLK settings from the eUSCI chapter of the user's guide
+// ("Recommended Settings for Typical Crystals and Baud Rates", BRCLK = 8000000)
+// mctlw = UCBRSx << 8 | UCBRFx << 4 | UCOS16
+const struct baud_setting baud_table[BAUDS] =
+{
+    {  9600, 52, 0x4911},
+    { 19200, 26, 0xB601},
+    { 38400, 13, 0x8401},
+    { 57600,  8, 0xF7A1},
+    {115200,  4, 0x5551},
+    {230400,  2, 0xBB21},
+    {460800, 17, 0x4A00}                            // UCOS16 = 0
+};
+
+enum peer_state
+{
+    PEER_HELLO,                                     // Sending hellos until 'A'
+    PEER_RUN,                                       // Waiting for a command
+    PEER_BUMP,                                      // 'B' received, index next
+    PEER_TEST,                                      // Echoing TEST_BYTES at the new rate
+    PEER_CONFIRM,                                   // Waiting for 'K'
+    PEER_SINK                                       // Counting THROUGHPUT_BYTES
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void use_baud(unsigned char index);                 // eUSCI_A0 at baud_table[index]
+unsigned char autobaud(void);                       // Returns the index, or NO_BAUD
+unsigned char nearest_baud(unsigned int bit_cycles);
+unsigned char negotiate(unsigned char index);       // Returns the fastest good index
+unsigned char test_link(void);                      // Errors in TEST_BYTES echoes
+unsigned char link_check(void);                     // 1 if 'P' is answered
+unsigned long throughput(void);                     // Bytes per second
+void uart_put(unsigned char data);
+unsigned char uart_get(unsigned char *data, unsigned int ticks); // 0 - late or UCRXERR
+void wait_ticks(unsigned int ticks);
+void flush_rx(void);
+
+void peer_start(unsigned char use_break);           // The gateway model on eUSCI_A1
+void peer_set_baud(unsigned char index);
+void peer_hello(void);
+void peer_put(unsigned char data);
+
+unsigned char autobaud_method;
+volatile unsigned int edges[5];                     // Last five falling edges on P1.2
+volatile unsigned char edge_count;
+volatile unsigned int capture_bit_cycles;           // 0 until five even edges are seen
+unsigned int rx_errors;                             // UCRXERR seen here
+
+volatile enum peer_state peer_state;
+volatile unsigned char peer_use_break;
+volatile unsigned char peer_index;                  // Rate the peer is using
+volatile unsigned char peer_good;                   // Rate to go back to
+volatile unsigned char peer_failed;                 // An error during PEER_TEST
+volatile unsigned int peer_count;
+volatile unsigned int peer_received;                // Last PEER_SINK total
+
+unsigned char lin_index = NO_BAUD;
+unsigned char capture_index = NO_BAUD;
+unsigned char negotiated_index;
+unsigned long negotiated_baud;
+unsigned char step_errors[BAUDS];
+unsigned long bytes_per_second_before;
+unsigned long bytes_per_second_after;
+unsigned char test_errors;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char index;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    P4SEL1 = 0x00;
+    P4SEL0 = BIT3 | BIT2;                           // P4.2 TXD, P4.3 RXD (eUSCI_A0)
+    P3SEL1 = 0x00;
+    P3SEL0 = BIT5 | BIT4;                           // P3.4 TXD, P3.5 RXD (eUSCI_A1, the peer)
+
+    TA2CTL = ACLK | CONTINUOUS | TACLR;             // Time-outs
+    _BIS_SR(GIE);
+
+    // LIN break + sync
+    peer_start(1);
+    index = autobaud();
+    if(autobaud_method == METHOD_LIN)
+    {
+        lin_index = index;
+    }
+    if(index != NO_BAUD)
+    {
+        bytes_per_second_before = throughput();
+        negotiated_index = negotiate(index);
+        negotiated_baud = baud_table[negotiated_index].baud;
+        bytes_per_second_after = throughput();
+    }
+
+    // No break, so UCABDEN sees nothing - the Timer1 capture has to find it
+    peer_start(0);
+    index = autobaud();
+    if(autobaud_method == METHOD_CAPTURE)
+    {
+        capture_index = index;
+    }
+
+    if(lin_index != PEER_START)
+    {
+        test_errors = test_errors + 1;
+    }
+    if(capture_index != PEER_START)
+    {
+        test_errors = test_errors + 1;
+    }
+    if((negotiated_index <= PEER_START) || (peer_received != THROUGHPUT_BYTES) ||
+       (bytes_per_second_after <= bytes_per_second_before))
+    {
+        test_errors = test_errors + 1;
+    }
+
+    if(test_errors == 0)
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+    else
+    {
+        P1OUT = BIT0;                               // Red LED - look at the globals
+    }
+
+    while(1)
+    {
+        _BIS_SR(LPM0_bits | GIE);
+    }
+}
+
+// ******************************
+// Autobaud - UCABDEN first, then Timer1 capture
+// ******************************
+unsigned char autobaud(void)
+{
+    unsigned char data;
+    unsigned char index = NO_BAUD;
+    unsigned int start;
+
+    autobaud_method = METHOD_NONE;
+
+    UCA0CTLW0 = UCSWRST | UART_CLK_SEL | UCMODE_3;  // Automatic baud-rate detection
+    UCA0BRW = 0;
+    UCA0MCTLW = UCOS16;                             // Measured into UCBRx and UCBRFx
+    UCA0ABCTL = UCABDEN;
+    UCA0CTLW0 = UCA0CTLW0 & ~UCSWRST;
+
+    if(uart_get(&data, LIN_TICKS) && (data == 'H') && !(UCA0ABCTL & (UCSTOE | UCBTOE)))
+    {
+        index = nearest_baud((UCA0BRW << 4) + ((UCA0MCTLW >> 4) & 0x0F));
+        autobaud_method = METHOD_LIN;
+    }
+
+    if(index == NO_BAUD)
+    {
+        UCA0CTLW0 = UCSWRST;                        // Leave the pin to Timer1
+        P1DIR = P1DIR & ~BIT2;
+        P1SEL1 = P1SEL1 & ~BIT2;
+        P1SEL0 = P1SEL0 | BIT2;                     // P1.2 is TA1.CCI1A
+
+        edge_count = 0;
+        capture_bit_cycles = 0;
+        TA1CCTL1 = CM_2 | CCIS_0 | SCS | CAP | CCIE; // Falling edges
+        TA1CTL = SMCLK | CONTINUOUS | TACLR;
+
+        start = TA2R;
+        while((capture_bit_cycles == 0) && ((unsigned int)(TA2R - start) < CAPTURE_TICKS));
+        TA1CCTL1 = 0;
+        TA1CTL = 0;
+
+        if(capture_bit_cycles)
+        {
+            index = nearest_baud(capture_bit_cycles);
+            autobaud_method = METHOD_CAPTURE;
+        }
+    }
+
+    if(index != NO_BAUD)
+    {
+        use_baud(index);
+        wait_ticks(GUARD_TICKS);                    // Let the rest of the hello go by
+        flush_rx();
+        uart_put('A');
+    }
+    return index;
+}
+
+unsigned char nearest_baud(unsigned int bit_cycles)
+{
+    unsigned char i;
+    unsigned int expected;
+    unsigned int difference;
+
+    for(i = 0; i < BAUDS; i = i + 1)
+    {
+        expected = CPU_HZ / baud_table[i].baud;
+        if(bit_cycles > expected)
+        {
+            difference = bit_cycles - expected;
+        }
+        else
+        {
+            difference = expected - bit_cycles;
+        }
+        if(difference <= (expected >> 5))           // Within 1/32
+        {
+            return i;
+        }
+    }
+    return NO_BAUD;
+}
+
+// ******************************
+// Negotiation - step up while the link stays clean
+// ******************************
+unsigned char negotiate(unsigned char index)
+{
+    unsigned char next;
+    unsigned char data;
+    unsigned char errors;
+
+    for(next = index + 1; next < BAUDS; next = next + 1)
+    {
+        uart_put('B');
+        uart_put(next);
+        if(!uart_get(&data, REPLY_TICKS) || (data != 'b'))
+        {
+            break;                                  // The peer said no
+        }
+        wait_ticks(GUARD_TICKS);
+        use_baud(next);
+        wait_ticks(GUARD_TICKS);
+
+        errors = test_link();
+        step_errors[next] = errors;
+        if(errors == 0)
+        {
+            uart_put('K');
+            if(uart_get(&data, REPLY_TICKS) && (data == 'K'))
+            {
+                index = next;                       // Both keep it
+                continue;
+            }
+        }
+
+        wait_ticks(PEER_REVERT_TICKS + REPLY_TICKS); // The peer goes back by itself
+        use_baud(index);
+        if(!link_check())                           // It got the 'K' after all
+        {
+            use_baud(next);
+            if(link_check())
+            {
+                index = next;
+            }
+        }
+        break;
+    }
+    return index;
+}
+
+unsigned char test_link(void)
+{
+    unsigned char i;
+    unsigned char data;
+    unsigned char echo;
+    unsigned char errors = 0;
+
+    for(i = 0; i < TEST_BYTES; i = i + 1)
+    {
+        data = SYNC + i * 37;                       // A different bit pattern each time
+        uart_put(data);
+        if(!uart_get(&echo, REPLY_TICKS) || (echo != data))
+        {
+            errors = errors + 1;
+        }
+    }
+    return errors;
+}
+
+unsigned char link_check(void)
+{
+    unsigned char data;
+
+    flush_rx();
+    uart_put('P');
+    return uart_get(&data, REPLY_TICKS) && (data == 'p');
+}
+
+unsigned long throughput(void)
+{
+    unsigned int i;
+    unsigned int start;
+    unsigned int ticks;
+    unsigned char data;
+
+    uart_put('C');
+    start = TA2R;
+    for(i = 0; i < THROUGHPUT_BYTES; i = i + 1)
+    {
+        uart_put(i);
+    }
+    if(!uart_get(&data, REPLY_TICKS) || (data != 'c'))
+    {
+        return 0;                                   // The peer lost some
+    }
+    ticks = TA2R - start;
+    return ((unsigned long)THROUGHPUT_BYTES * TICKS_PER_SECOND) / ticks;
+}
+
+// ******************************
+// eUSCI_A0
+// ******************************
+void use_baud(unsigned char index)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0ABCTL = 0;
+    UCA0BRW = baud_table[index].brw;
+    UCA0MCTLW = baud_table[index].mctlw;
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
+
+void uart_put(unsigned char data)
+{
+    while(!(UCA0IFG & UCTXIFG));                    // Wait for room
+    UCA0TXBUF = data;
+}
+
+unsigned char uart_get(unsigned char *data, unsigned int ticks)
+{
+    unsigned int start = TA2R;
+    unsigned int status;
+
+    while(!(UCA0IFG & UCRXIFG))
+    {
+        if((unsigned int)(TA2R - start) > ticks)
+        {
+            return 0;
+        }
+    }
+    status = UCA0STATW;                             // Before UCA0RXBUF clears it
+    *data = UCA0RXBUF;
+    if(status & UCRXERR)
+    {
+        rx_errors = rx_errors + 1;
+        return 0;
+    }
+    return 1;
+}
+
+void wait_ticks(unsigned int ticks)
+{
+    unsigned int start = TA2R;
+
+    while((unsigned int)(TA2R - start) < ticks);
+}
+
+void flush_rx(void)
+{
+    unsigned char data;
+
+    while(UCA0IFG & UCRXIFG)
+    {
+        data = UCA0RXBUF;
+    }
+    (void)data;
+}
+
+// ****************************************************
+// Timer1 ISR - falling edges on P1.2 (the RX pin)
+// ****************************************************
+#pragma vector=TIMER1_A1_VECTOR
+__interrupt void Timer1_Capture_ISR(void)
+{
+    unsigned char i;
+    unsigned int first;
+    unsigned int gap;
+
+    switch(__even_in_range(TA1IV, TA1IV_TAIFG))
+    {
+        case TA1IV_TACCR1:
+        {
+            for(i = 0; i < 4; i = i + 1)            // Keep the last five
+            {
+                edges[i] = edges[i + 1];
+            }
+            edges[4] = TA1CCR1;
+            if(edge_count < 5)
+            {
+                edge_count = edge_count + 1;
+            }
+            if(edge_count < 5)
+            {
+                break;
+            }
+
+            first = edges[1] - edges[0];            // Two bits of 0x55
+            for(i = 1; i < 4; i = i + 1)
+            {
+                gap = edges[i + 1] - edges[i];
+                if(gap > first)
+                {
+                    gap = gap - first;
+                }
+                else
+                {
+                    gap = first - gap;
+                }
+                if(gap > (first >> 3))              // Not evenly spaced - not the sync
+                {
+                    break;
+                }
+            }
+            if(i == 4)
+            {
+                capture_bit_cycles = (edges[4] - edges[0]) >> 3;
+                TA1CCTL1 = 0;
+            }
+            break;
+        }
+    }
+}
+
+// *************************************************************************
+// The peer - a gateway model on eUSCI_A1 (self test only)
+// *************************************************************************
+void peer_start(unsigned char use_break)
+{
+    peer_use_break = use_break;
+    peer_good = PEER_START;
+    peer_set_baud(PEER_START);
+    peer_state = PEER_HELLO;
+    UCA1IE = UCRXIE;
+
+    TA3CCR0 = HELLO_TICKS;
+    TA3CTL = ACLK | UP | TACLR;
+    TA3CCTL0 = CCIE;
+}
+
+void peer_set_baud(unsigned char index)
+{
+    UCA1CTLW0 = UCSWRST | UART_CLK_SEL | UCMODE_3;  // UCMODE_3 to send breaks
+    UCA1BRW = baud_table[index].brw;
+    UCA1MCTLW = baud_table[index].mctlw;
+    UCA1CTLW0 = UCA1CTLW0 & ~UCSWRST;
+    UCA1IE = UCRXIE;                                // UCSWRST cleared it
+    peer_index = index;
+}
+
+void peer_hello(void)
+{
+    if(peer_use_break)
+    {
+        UCA1CTLW0 = UCA1CTLW0 | UCTXBRK;            // Next byte goes out as break + sync
+    }
+    peer_put(SYNC);
+    peer_put('H');
+}
+
+void peer_put(unsigned char data)
+{
+    while(!(UCA1IFG & UCTXIFG));
+    UCA1TXBUF = data;
+}
+
+#pragma vector=USCI_A1_VECTOR
+__interrupt void Peer_UART_ISR(void)
+{
+    unsigned int status;
+    unsigned char data;
+
+    if(!(UCA1IFG & UCRXIFG))
+    {
+        return;
+    }
+    status = UCA1STATW;
+    data = UCA1RXBUF;
+
+    switch(peer_state)
+    {
+        case PEER_HELLO:
+        {
+            if(data == 'A')
+            {
+                TA3CCTL0 = 0;                       // No more hellos
+                peer_state = PEER_RUN;
+            }
+            break;
+        }
+
+        case PEER_RUN:
+        {
+            if(data == 'B')
+            {
+                peer_state = PEER_BUMP;
+            }
+            else if(data == 'P')
+            {
+                peer_put('p');
+            }
+            else if(data == 'C')
+            {
+                peer_count = 0;
+                peer_state = PEER_SINK;
+            }
+            break;
+        }
+
+        case PEER_BUMP:
+        {
+            peer_state = PEER_RUN;
+            if((status & UCRXERR) || (data >= BAUDS))
+            {
+                break;                              // No 'b' - we stay here
+            }
+            peer_put('b');
+            while(UCA1STATW & UCBUSY);              // Let the 'b' go at the old rate
+            peer_set_baud(data);
+            peer_count = 0;
+            peer_failed = 0;
+            peer_state = PEER_TEST;
+
+            TA3CCR0 = PEER_REVERT_TICKS;            // Back to peer_good without a 'K'
+            TA3CTL = ACLK | UP | TACLR;
+            TA3CCTL0 = CCIE;
+            break;
+        }
+
+        case PEER_TEST:
+        {
+            if(status & UCRXERR)
+            {
+                peer_failed = 1;
+            }
+            peer_put(data);                         // Echo it, right or wrong
+            peer_count = peer_count + 1;
+            if(peer_count == TEST_BYTES)
+            {
+                peer_state = PEER_CONFIRM;
+            }
+            break;
+        }
+
+        case PEER_CONFIRM:
+        {
+            if((data == 'K') && !(status & UCRXERR) && !peer_failed)
+            {
+                TA3CCTL0 = 0;
+                peer_good = peer_index;
+                peer_state = PEER_RUN;
+                peer_put('K');
+            }
+            break;
+        }
+
+        case PEER_SINK:
+        {
+            peer_count = peer_count + 1;
+            if(peer_count == THROUGHPUT_BYTES)
+            {
+                peer_received = peer_count;
+                peer_state = PEER_RUN;
+                peer_put('c');
+            }
+            break;
+        }
+    }
+}
+
+// ****************************************************
+// Timer3 ISR - the peer's hellos and its time-out
+// ****************************************************
+#pragma vector=TIMER3_A0_VECTOR
+__interrupt void Peer_Timer_ISR(void)
+{
+    if(peer_state == PEER_HELLO)
+    {
+        peer_hello();
+    }
+    else if((peer_state == PEER_TEST) || (peer_state == PEER_CONFIRM))
+    {
+        TA3CCTL0 = 0;                               // No 'K' - go back
+        peer_set_baud(peer_good);
+        peer_state = PEER_RUN;
+    }
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
@@ -0,0 +1,321 @@
+/*
+ * fmt.c - the formatter, divide by 10 with MPY32, and the UART TX ring for fmt.h
+ *
+ * fmt() and fmt_buffer() are for main() only (they share one output "sink"), and fmt()
+ * needs interrupts on if the ring fills up. This file has the USCI_A0_VECTOR ISR.
+ */
+
+#include <msp430.h>
+#include <stdarg.h>
+#include "fmt.h"
+
+#define MPY_WAIT                4                   // RES2 / RES3 are ready a few cycles after OP2H
+
+static char ring[FMT_RING_SIZE];
+static volatile unsigned char ring_head;            // Written by fmt()
+static volatile unsigned char ring_tail;            // Written by the ISR
+volatile unsigned int fmt_sent;                     // Bytes the ISR has sent
+
+static char *sink;                                  // 0 - the ring, or fmt_buffer()'s array...
+static char *sink_end;                              // ...up to here
+static unsigned int sink_count;
+
+static void put(char c);
+static void format(const char *f, va_list args);
+static unsigned long div10(unsigned long x, unsigned char *remainder);
+
+void fmt_init(void)
+{
+    ring_head = 0;
+    ring_tail = 0;
+    fmt_sent = 0;
+}
+
+void fmt(const char *format_text, ...)
+{
+    va_list args;
+
+    sink = 0;
+    va_start(args, format_text);
+    format(format_text, args);
+    va_end(args);
+}
+
+unsigned int fmt_buffer(char *buffer, unsigned int size, const char *format_text, ...)
+{
+    va_list args;
+
+    sink = buffer;
+    sink_end = buffer + size - 1;                   // Room for the 0
+    sink_count = 0;
+    va_start(args, format_text);
+    format(format_text, args);
+    va_end(args);
+    *sink = 0;
+    sink = 0;
+    return sink_count;
+}
+
+void fmt_flush(void)
+{
+    while(ring_head != ring_tail);                  // The ISR is still sending
+    while(UCA0STATW & UCBUSY);                      // The last stop bit
+}
+
+// ******************************
+// One character out
+// ******************************
+static void put(char c)
+{
+    unsigned char next;
+
+    if(sink)
+    {
+        if(sink < sink_end)
+        {
+            *sink = c;
+            sink = sink + 1;
+            sink_count = sink_count + 1;
+        }
+        return;
+    }
+
+    next = (ring_head + 1) & (FMT_RING_SIZE - 1);
+    while(next == ring_tail);                       // Full - wait for the ISR
+    ring[ring_head] = c;
+    ring_head = next;
+    UCA0IE = UCA0IE | UCTXIE;                       // UCTXIFG is HI if the ISR left the line idle
+}
+
+// ******************************
+// x / 10 with the hardware multiplier
+// ******************************
+static unsigned long div10(unsigned long x, unsigned char *remainder)
+{
+    unsigned long quotient;
+    unsigned int sr;
+
+    sr = __get_SR_register();
+    __disable_interrupt();                          // MPY32 is ours for a moment
+    MPY32L = x & 0xFFFF;
+    MPY32H = x >> 16;
+    OP2L = 0xCCCD;
+    OP2H = 0xCCCC;                                  // Starts the 32 x 32 multiply
+    __delay_cycles(MPY_WAIT);
+    quotient = (((unsigned long)RES3 << 16) | RES2) >> 3; // Bits 35 to 63
+    __bis_SR_register(sr & GIE);                    // GIE back the way it was
+
+    *remainder = x - (quotient << 3) - (quotient << 1); // x - quotient * 10
+    return quotient;
+}
+
+// ******************************
+// The formatter
+// ******************************
+static void format(const char *f, va_list args)
+{
+    char text[13];                                  // Sign, 10 digits, point, backwards
+    unsigned char n;
+    unsigned char width;
+    unsigned char precision;
+    unsigned char zeros;
+    unsigned char is_long;
+    unsigned char negative;
+    unsigned char digit;
+    unsigned long value;
+    const char *s;
+
+    while(*f)
+    {
+        if(*f != '%')
+        {
+            put(*f);
+            f = f + 1;
+            continue;
+        }
+        f = f + 1;
+
+        zeros = 0;
+        width = 0;
+        precision = 0;
+        is_long = 0;
+        negative = 0;
+        n = 0;
+
+        if(*f == '0')
+        {
+            zeros = 1;
+            f = f + 1;
+        }
+        while((*f >= '0') && (*f <= '9'))
+        {
+            width = (width << 3) + (width << 1) + (*f - '0'); // * 10
+            f = f + 1;
+        }
+        if(*f == '.')
+        {
+            f = f + 1;
+            if((*f >= '0') && (*f <= '9'))
+            {
+                precision = *f - '0';
+                f = f + 1;
+            }
+        }
+        if(*f == 'l')
+        {
+            is_long = 1;
+            f = f + 1;
+        }
+
+        switch(*f)
+        {
+            case 'd':
+            case 'q':
+            case 'u':
+            {
+                if(*f == 'u')
+                {
+                    value = is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                }
+                else
+                {
+                    value = is_long ? va_arg(args, long) : (long)va_arg(args, int);
+                    if((long)value < 0)
+                    {
+                        negative = 1;
+                        value = 0 - value;
+                    }
+                }
+                if(*f != 'q')
+                {
+                    precision = 0;
+                }
+
+                do                                  // Digits, last one first
+                {
+                    value = div10(value, &digit);
+                    text[n] = '0' + digit;
+                    n = n + 1;
+                    if(n == precision)
+                    {
+                        if(value == 0)              // "0.05", not ".05"
+                        {
+                            text[n] = '.';
+                            text[n + 1] = '0';
+                            n = n + 2;
+                            break;
+                        }
+                        text[n] = '.';
+                        n = n + 1;
+                    }
+                } while((value != 0) || (n < precision));
+                break;
+            }
+
+            case 'x':
+            {
+                value = is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                do
+                {
+                    digit = value & 0x0F;
+                    text[n] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+                    n = n + 1;
+                    value = value >> 4;
+                } while(value != 0);
+                break;
+            }
+
+            case 's':
+            case 'c':
+            {
+                if(*f == 's')
+                {
+                    s = va_arg(args, const char *);
+                    for(n = 0; s[n] && (n < 0xFF); n = n + 1);
+                }
+                else
+                {
+                    text[0] = va_arg(args, int);
+                    s = text;
+                    n = 1;
+                }
+                for(; width > n; width = width - 1)
+                {
+                    put(' ');
+                }
+                while(n > 0)
+                {
+                    put(*s);
+                    s = s + 1;
+                    n = n - 1;
+                }
+                f = f + 1;
+                continue;
+            }
+
+            case 0:                                 // A '%' at the very end
+            {
+                return;
+            }
+
+            default:                                // "%%", or something we do not know
+            {
+                put(*f);
+                f = f + 1;
+                continue;
+            }
+        }
+        f = f + 1;
+
+        if(negative)                                // Numbers - sign, padding, digits
+        {
+            if(width > 0)
+            {
+                width = width - 1;
+            }
+            if(zeros)
+            {
+                put('-');
+            }
+        }
+        for(; width > n; width = width - 1)
+        {
+            put(zeros ? '0' : ' ');
+        }
+        if(negative && !zeros)
+        {
+            put('-');
+        }
+        while(n > 0)
+        {
+            n = n - 1;
+            put(text[n]);
+        }
+    }
+}
+
+// ****************************************************
+// UART ISR - empties the ring
+// ****************************************************
+#pragma vector=USCI_A0_VECTOR
+__interrupt void Fmt_UART_ISR(void)
+{
+    switch(__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG))
+    {
+        case USCI_UART_UCTXIFG:
+        {
+            if(ring_tail != ring_head)
+            {
+                UCA0TXBUF = ring[ring_tail];
+                ring_tail = (ring_tail + 1) & (FMT_RING_SIZE - 1);
+                fmt_sent = fmt_sent + 1;
+            }
+            else
+            {
+                UCA0IFG = UCA0IFG | UCTXIFG;        // Reading UCA0IV cleared it - set it again,
+                UCA0IE = UCA0IE & ~UCTXIE;          // so the next put() gets an interrupt
+            }
+            break;
+        }
+    }
+}
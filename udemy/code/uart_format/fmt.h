@@ -0,0 +1,50 @@
+/*
+ * fmt.h - printing numbers and text to the UART, printf style
+ *
+ * uart_challenge_1 can only send raw bytes (0x0A, 0x09...). fmt() turns numbers into
+ * text the way printf() does, with only what we need:
+ *
+ *      %d  %u      int, unsigned int               fmt("count %u\r\n", count);
+ *      %ld %lu     long, unsigned long
+ *      %x  %lx     hex, upper case, no 0x          fmt("P1OUT %02x\r\n", P1OUT);
+ *      %s  %c      text, one character
+ *      %.Nq %.Nlq  FIXED POINT - the number is in 1/10^N units, printed with N decimals:
+ *                  fmt("%.2q V", 330) gives "3.30 V", fmt("%.1q", -5) gives "-0.5"
+ *      %%          a %
+ *
+ * A width (%5u) pads with spaces, %05u pads with zeros. There are no floats, no heap,
+ * and the stack use is fixed (the longest number is 11 characters).
+ *
+ * NO DIVISION
+ * -----------
+ * Printing a number in decimal needs "divide by 10" again and again, and the MSP430 has
+ * no divide instruction (the library routine takes hundreds of cycles). Instead the
+ * 32-bit hardware multiplier (MPY32) works out
+ *
+ *      x / 10 = (x * 0xCCCCCCCD) >> 35
+ *
+ * which is exact for every 32-bit x. Interrupts are off for the few cycles it uses
+ * MPY32, in case an ISR multiplies too.
+ *
+ * OUTPUT
+ * ------
+ * fmt() writes into a FMT_RING_SIZE byte ring that the UART TX interrupt empties, so the
+ * caller only waits if the ring is full. fmt_buffer() writes into a char array instead
+ * (always ending in a 0) - for the self test, or to build a line before sending it.
+ */
+
+#ifndef FMT_H_
+#define FMT_H_
+
+#include <msp430.h>
+
+#define FMT_RING_SIZE           64                  // Must be a power of 2
+
+extern volatile unsigned int fmt_sent;              // Bytes sent from the ring
+
+void fmt_init(void);                                // eUSCI_A0 TX interrupt on
+void fmt(const char *format, ...);                  // Into the UART TX ring
+unsigned int fmt_buffer(char *buffer, unsigned int size, const char *format, ...); // Length
+void fmt_flush(void);                               // Wait until the ring is empty
+
+#endif /* FMT_H_ */
@@ -0,0 +1,293 @@
+/*
+ * Printing numbers as text over the UART with fmt.h
+ *
+ * uart_challenge_1 sends the count-down as raw bytes 0x0A, 0x09... that a terminal
+ * can not show. Here the same count-down goes out as text, one line a second:
+ *
+ *      T-10  vcc 3.30 V  uptime 0000001s
+ *      ...
+ *      liftoff
+ *
+ * and then the uptime keeps going. Connect a terminal at 9600 baud (P4.2).
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * First every kind of conversion is printed with fmt_buffer() and compared with what it
+ * must be. format_errors counts the ones that are wrong (0 - the green LED is on).
+ *
+ * ring_errors - two separate fmt() calls go out through the TX ring, the second only
+ * after the first has been sent. Each must be sent in full (fmt_sent) within
+ * RING_WAIT_LOOPS.
+ *
+ * Then Timer1 (1 count = 1 cycle at 8MHz) times each of the BENCH_FORMATS conversions
+ * into fmt_cycles[]. With COMPARE_TI_PRINTF set to 1 the same numbers are also printed
+ * with sprintf() from the TI library into ti_cycles[]. Build with --printf_support=
+ * minimal, and the .map file shows the code size of each: fmt.obj next to the
+ * library's _printfi_min (and the division routines it pulls in).
+ */
+
+#include <msp430.h>
+#include "fmt.h"
+
+#ifndef COMPARE_TI_PRINTF
+#define COMPARE_TI_PRINTF       0                   // 1 - also time the library sprintf()
+#endif
+
+#if COMPARE_TI_PRINTF
+#include <stdio.h>
+#endif
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                // Value required to use 9600 baud
+#define CLK_MOD                 0x4911              // uC will "clean up" clock signal
+#define BENCH_FORMATS           5
+#define LINE_SIZE               40
+#define RING_LINE_1             "ring 1\r\n"
+#define RING_LINE_2             "ring 22\r\n"
+#define RING_LENGTH_1           8
+#define RING_LENGTH_2           9
+#define RING_WAIT_LOOPS         10000               // * 100 cycles = 125ms, 9600 baud needs 10ms
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void assign_pins_to_uart(void);                     // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                           // UART operates at 9600 bits per second
+void run_self_test(void);
+void run_benchmark(void);
+void run_ring_test(void);                           // Needs interrupts on
+void wait_sent(unsigned int count);                 // Or a ring error
+void check(const char *expected);                   // line[] against expected
+
+char line[LINE_SIZE];
+unsigned char format_errors;
+unsigned char ring_errors;
+unsigned int fmt_cycles[BENCH_FORMATS];             // %u, %d, %lu, %.2q, %lx
+unsigned int ti_cycles[BENCH_FORMATS];              // %u, %d, %lu, %d.%02d, %lx
+
+volatile unsigned char tick;                        // Timer0, every second
+unsigned long uptime;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    signed char countdown = 10;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    assign_pins_to_uart();
+    use_9600_baud();
+    fmt_init();
+
+    run_self_test();
+    run_benchmark();
+
+    TA0CCR0 = 40000;                                // 1 second
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+    _BIS_SR(GIE);
+
+    run_ring_test();
+    if((format_errors == 0) && (ring_errors == 0))
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+
+    fmt("\r\nfmt: %u errors, %u cycles for %%lu\r\n", format_errors, fmt_cycles[2]);
+
+    while(1)
+    {
+        _BIS_SR(LPM0_bits | GIE);                   // Timer0 wakes us every second
+        if(!tick)
+        {
+            continue;
+        }
+        tick = 0;
+        uptime = uptime + 1;
+
+        if(countdown > 0)
+        {
+            fmt("T-%02d  vcc %.2q V  uptime %07lus\r\n", countdown, 330, uptime);
+            countdown = countdown - 1;
+        }
+        else if(countdown == 0)
+        {
+            fmt("liftoff\r\n");
+            P1OUT = BIT0;                           // Turn on the red LED, like uart_challenge_1
+            countdown = -1;
+        }
+        else
+        {
+            fmt("uptime %lu s  P1OUT %02x\r\n", uptime, P1OUT);
+        }
+    }
+}
+
+// ****************************************************
+// Self test - every conversion against what it must be
+// ****************************************************
+void run_self_test(void)
+{
+    fmt_buffer(line, LINE_SIZE, "%d|%u|%x", -123, 65535u, 0xBEEFu);
+    check("-123|65535|BEEF");
+    fmt_buffer(line, LINE_SIZE, "%05d|%5u|%04x", -42, 7u, 0x1Au);
+    check("-0042|    7|001A");
+    fmt_buffer(line, LINE_SIZE, "%ld %lu %lx", -2147483647L - 1, 4294967295UL, 0xDEADBEEFUL);
+    check("-2147483648 4294967295 DEADBEEF");
+    fmt_buffer(line, LINE_SIZE, "%.2q V|%.1q|%.3lq", 330, -5, 1234567L);
+    check("3.30 V|-0.5|1234.567");
+    fmt_buffer(line, LINE_SIZE, "%s:%c:%6s|%%|%d", "hi", 'Z', "ab", 0);
+    check("hi:Z:    ab|%|0");
+    fmt_buffer(line, 8, "%lu", 4294967295UL);       // Cut short, still ends in a 0
+    check("4294967");
+}
+
+// ****************************************************
+// Self test - the ring must start again after it empties
+// ****************************************************
+void run_ring_test(void)
+{
+    unsigned int start = fmt_sent;
+
+    fmt(RING_LINE_1);
+    wait_sent(start + RING_LENGTH_1);               // The ISR found the ring empty here...
+    fmt(RING_LINE_2);
+    wait_sent(start + RING_LENGTH_1 + RING_LENGTH_2); // ...so this only goes if it restarts
+}
+
+void wait_sent(unsigned int count)
+{
+    unsigned int loops = 0;
+
+    while((fmt_sent != count) && (loops < RING_WAIT_LOOPS))
+    {
+        __delay_cycles(100);
+        loops = loops + 1;
+    }
+    if(fmt_sent != count)
+    {
+        ring_errors = ring_errors + 1;              // Stuck - fmt_flush() would wait for ever
+    }
+    else
+    {
+        fmt_flush();                                // The last stop bit
+    }
+}
+
+void check(const char *expected)
+{
+    unsigned char i = 0;
+
+    while(line[i] && (line[i] == expected[i]))
+    {
+        i = i + 1;
+    }
+    if(line[i] != expected[i])
+    {
+        format_errors = format_errors + 1;
+    }
+}
+
+// ****************************************************
+// Benchmark - cycles for one conversion
+// ****************************************************
+void run_benchmark(void)
+{
+    unsigned int start;
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    start = TA1R;
+    fmt_buffer(line, LINE_SIZE, "%u", 65535u);
+    fmt_cycles[0] = TA1R - start;
+    start = TA1R;
+    fmt_buffer(line, LINE_SIZE, "%d", -12345);
+    fmt_cycles[1] = TA1R - start;
+    start = TA1R;
+    fmt_buffer(line, LINE_SIZE, "%lu", 4294967295UL);
+    fmt_cycles[2] = TA1R - start;
+    start = TA1R;
+    fmt_buffer(line, LINE_SIZE, "%.2q", 330);
+    fmt_cycles[3] = TA1R - start;
+    start = TA1R;
+    fmt_buffer(line, LINE_SIZE, "%lx", 0xDEADBEEFUL);
+    fmt_cycles[4] = TA1R - start;
+
+#if COMPARE_TI_PRINTF
+    start = TA1R;
+    sprintf(line, "%u", 65535u);
+    ti_cycles[0] = TA1R - start;
+    start = TA1R;
+    sprintf(line, "%d", -12345);
+    ti_cycles[1] = TA1R - start;
+    start = TA1R;
+    sprintf(line, "%lu", 4294967295UL);
+    ti_cycles[2] = TA1R - start;
+    start = TA1R;
+    sprintf(line, "%d.%02d", 330 / 100, 330 % 100); // No fixed point in the library
+    ti_cycles[3] = TA1R - start;
+    start = TA1R;
+    sprintf(line, "%lx", 0xDEADBEEFUL);
+    ti_cycles[4] = TA1R - start;
+#endif
+
+    TA1CTL = 0;
+}
+
+// *************************************************************************
+// Timer0 ISR
+// *************************************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    tick = 1;
+    __bic_SR_register_on_exit(LPM0_bits);           // Wake up main()
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
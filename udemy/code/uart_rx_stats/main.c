@@ -0,0 +1,482 @@
+/*
+ * UART receive with error counters, break and idle detection
+ *
+ * uart_tx_rx_isr just reads UCA0RXBUF. If a byte arrives before the last one was read,
+ * the old one is gone (an OVERRUN) and nothing tells us. The eUSCI does tell us, in
+ * UCA0STATW, which has to be read BEFORE UCA0RXBUF (reading UCA0RXBUF clears it):
+ *
+ *      UCOE    overrun - a byte was lost before this one (this one is still good)
+ *      UCFE    framing error - the stop bit was LO (wrong baud rate, noise)
+ *      UCPE    parity error - the parity bit does not match (noise)
+ *      UCBRK   break - the line was held LO for a whole character or more
+ *
+ * UCRXEIE lets bytes with FE or PE through to the ISR (so they can be counted) and
+ * UCBRKIE does the same for breaks. Bad bytes are counted and thrown away, good ones go
+ * into rx_ring[] for main().
+ *
+ * IDLE LINE
+ * ---------
+ * Every byte moves TA1CCR0 to IDLE_CHARS character times later. If it gets there, no
+ * byte came for that long - the end of a burst (a "frame") - and idles is counted.
+ *
+ * LATENCY
+ * -------
+ * The ISR has one character time to read UCA0RXBUF before the next byte overruns it.
+ * The worst wait is the longest time another ISR can keep it out, plus the time the RX
+ * ISR itself takes. Both are measured with Timer1 (1 count = 1 cycle), so for each
+ * rate latency_bound_cycles can be compared with char_cycles and latency_ok says if
+ * no byte was at risk in THIS run. That is a measurement, not a promise - a longer ISR
+ * added later breaks it.
+ *
+ * RX BY DMA
+ * ---------
+ * The promise comes from taking the CPU out of the path. With rx_dma set, UCA0RXIFG
+ * triggers DMA channel 0 (DMA0TSEL_14), which copies UCA0RXBUF straight into rx_ring[]
+ * in repeated single transfer mode (DMADT_4 - it starts again at rx_ring[0] after
+ * RING_SIZE bytes). A DMA transfer only waits for the instruction the CPU is on, never
+ * for an ISR, so at these rates no byte can be overrun however busy the CPU is. The
+ * head of the ring is RING_SIZE - DMA0SZ (DMA0SZ counts down what is left).
+ *
+ * What is given up: without an ISR for each byte there are no error counters and no
+ * idle detection. UCRXEIE and UCBRKIE are off, so the eUSCI throws bytes with FE or PE
+ * and breaks away itself - they never reach the ring. Nothing stops the DMA writing
+ * over bytes main() has not read yet, so main() must keep up (a gap in the numbers
+ * shows it if it does not).
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * Jumper P3.4 (eUSCI_A1 TXD) to P4.3 (eUSCI_A0 RXD). eUSCI_A1 sends BURSTS bursts of
+ * BURST_BYTES numbered bytes at 9600, 115200 and 460800 (even parity). Every NOISE_EVERY
+ * bursts it also sends a byte with the WRONG parity and a break. Meanwhile Timer2 takes
+ * LOAD_CYCLES of the CPU LOAD_HZ times a second, like a busy program would.
+ *
+ * stats[] has, for each rate, what was sent, received and dropped (from the gaps in the
+ * numbers), drop_ppm (drops per million), every error counter, and the latency check.
+ * The parity and break counts must match what was injected (noise_errors counts the
+ * ones that do not). Then the same bursts, noise and load are run again with rx_dma
+ * set, into dma_stats[]. Green LED: no drops where latency_ok says there can not be
+ * any, and no drops at all with the DMA.
+ */
+
+#include <msp430.h>
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define CPU_HZ                  8000000UL           // SMCLK after select_clock_signals()
+
+#define RATES                   3
+#define RING_SIZE               64                  // Must be a power of 2
+#define BITS_PER_CHAR           11                  // Start, 8 data, parity, stop
+#define IDLE_CHARS              2
+#define BURSTS                  64
+#define BURST_BYTES             32
+#define NOISE_EVERY             8
+#define LOAD_HZ                 2000                // Timer2 "busy program"
+#define LOAD_CYCLES             600
+
+struct baud_setting
+{
+    unsigned long baud;
+    unsigned int brw;                               // UCAxBRW
+    unsigned int mctlw;                             // UCAxMCTLW
+};
+
+const struct baud_setting rates[RATES] =
+{
+    {  9600, 52, 0x4911},
+    {115200,  4, 0x5551},
+    {460800, 17, 0x4A00}
+};
+
+struct rx_stats
+{
+    unsigned long sent;
+    unsigned long received;                         // Good bytes that reached main()
+    unsigned long dropped;                          // Missing numbers
+    unsigned long drop_ppm;
+    unsigned int overruns;                          // UCOE
+    unsigned int framing;                           // UCFE
+    unsigned int parity;                            // UCPE
+    unsigned int breaks;                            // UCBRK
+    unsigned int idles;                             // Gaps of IDLE_CHARS
+    unsigned int ring_full;                         // main() too slow
+    unsigned int char_cycles;
+    unsigned int latency_bound_cycles;
+    unsigned char latency_ok;
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void rx_init(unsigned char rate);                   // eUSCI_A0 - receiver
+void line_init(unsigned char rate);                 // eUSCI_A1 - the line we test with
+void line_put(unsigned char data);
+void line_put_bad_parity(unsigned char data);
+void line_put_break(void);
+void run_rate(unsigned char rate, unsigned char dma);
+void drain_ring(void);                              // main() side of rx_ring[]
+void rx_dma_init(void);                             // DMA channel 0 - UCA0RXBUF to rx_ring[]
+
+struct rx_stats stats[RATES];                       // RX ISR
+struct rx_stats dma_stats[RATES];                   // RX by DMA - no error counters
+struct rx_stats *now;                               // stats[] of the rate being tested
+
+unsigned char rx_dma;                               // 1 - the DMA fills rx_ring[], not the ISR
+volatile unsigned char rx_ring[RING_SIZE];
+volatile unsigned char rx_head;                     // Written by the ISR
+volatile unsigned char rx_tail;                     // Written by main()
+unsigned char expected;                             // Next number
+unsigned char have_expected;
+
+unsigned int idle_cycles;                           // IDLE_CHARS characters
+volatile unsigned int rx_isr_worst;                 // Cycles
+volatile unsigned int load_isr_worst;               // Cycles, entry latency included
+unsigned char noise_errors;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    unsigned char rate;
+
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    P4SEL1 = 0x00;
+    P4SEL0 = BIT3 | BIT2;                           // P4.2 TXD, P4.3 RXD (eUSCI_A0)
+    P3SEL1 = 0x00;
+    P3SEL0 = BIT5 | BIT4;                           // P3.4 TXD, P3.5 RXD (eUSCI_A1)
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+
+    TA2CCR0 = (CPU_HZ / LOAD_HZ) - 1;               // The "busy program"
+    TA2CTL = SMCLK | UP | TACLR;
+    TA2CCTL0 = CCIE;
+    _BIS_SR(GIE);
+
+    for(rate = 0; rate < RATES; rate = rate + 1)
+    {
+        run_rate(rate, 0);
+        run_rate(rate, 1);
+    }
+
+    TA2CCTL0 = 0;
+    P9OUT = BIT7;                                   // Green unless something below fails
+    for(rate = 0; rate < RATES; rate = rate + 1)
+    {
+        if(stats[rate].latency_ok && (stats[rate].dropped || stats[rate].ring_full))
+        {
+            P9OUT = 0x00;                           // Lost bytes the bound says we can not lose
+            P1OUT = BIT0;
+        }
+        if(dma_stats[rate].dropped)
+        {
+            P9OUT = 0x00;                           // The DMA must never lose one
+            P1OUT = BIT0;
+        }
+    }
+    if(noise_errors)
+    {
+        P9OUT = 0x00;
+        P1OUT = BIT0;
+    }
+
+    while(1)
+    {
+        _BIS_SR(LPM0_bits | GIE);
+    }
+}
+
+// ******************************
+// One rate - bursts, noise and breaks
+// ******************************
+void run_rate(unsigned char rate, unsigned char dma)
+{
+    unsigned char burst;
+    unsigned char i;
+    unsigned char number = 0;
+    unsigned int start;
+    unsigned int injected = 0;
+
+    if(dma)
+    {
+        now = &dma_stats[rate];
+    }
+    else
+    {
+        now = &stats[rate];
+    }
+    rx_dma = dma;
+    rx_isr_worst = 0;
+    load_isr_worst = 0;
+    have_expected = 0;
+
+    rx_init(rate);
+    if(dma)
+    {
+        rx_dma_init();
+        rx_tail = 0;                                // The DMA starts at rx_ring[0]
+    }
+    else
+    {
+        rx_tail = rx_head;
+    }
+    line_init(rate);
+
+    for(burst = 0; burst < BURSTS; burst = burst + 1)
+    {
+        for(i = 0; i < BURST_BYTES; i = i + 1)
+        {
+            line_put(number);
+            number = number + 1;
+            now->sent = now->sent + 1;
+            drain_ring();
+        }
+
+        if((burst % NOISE_EVERY) == NOISE_EVERY - 1)
+        {
+            line_put_bad_parity(0xAA);
+            line_put_break();
+            injected = injected + 1;
+        }
+
+        start = TA1R;                               // A gap, so the line goes idle
+        while((unsigned int)(TA1R - start) < 2 * idle_cycles)
+        {
+            drain_ring();
+        }
+    }
+    drain_ring();
+    DMA0CTL = 0;                                    // Stop the DMA (if it was on)
+
+    if(now->sent)
+    {
+        now->drop_ppm = (now->dropped * 1000000UL) / now->sent;
+    }
+    if(dma)
+    {
+        now->latency_ok = 1;                        // The DMA does not wait for ISRs
+        return;                                     // No error counters to check
+    }
+    now->latency_bound_cycles = load_isr_worst + rx_isr_worst;
+    now->latency_ok = now->latency_bound_cycles < now->char_cycles;
+
+    if((now->parity != injected) || (now->breaks != injected))
+    {
+        noise_errors = noise_errors + 1;
+    }
+}
+
+void drain_ring(void)
+{
+    unsigned char data;
+    unsigned char head;
+
+    if(rx_dma)
+    {
+        head = (RING_SIZE - DMA0SZ) & (RING_SIZE - 1);  // Where the DMA writes next
+    }
+    else
+    {
+        head = rx_head;
+    }
+
+    while(rx_tail != head)
+    {
+        data = rx_ring[rx_tail];
+        rx_tail = (rx_tail + 1) & (RING_SIZE - 1);
+        now->received = now->received + 1;
+
+        if(have_expected && (data != expected))
+        {
+            now->dropped = now->dropped + (unsigned char)(data - expected);
+        }
+        expected = data + 1;
+        have_expected = 1;
+    }
+}
+
+// ******************************
+// eUSCI_A0 - the receiver
+// ******************************
+void rx_init(unsigned char rate)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    if(rx_dma)
+    {
+        UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL | UCPEN | UCPAR; // Even parity, errors thrown away
+    }
+    else
+    {
+        UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL | UCPEN | UCPAR | UCRXEIE | UCBRKIE; // Even parity, let errors in
+    }
+    UCA0BRW = rates[rate].brw;
+    UCA0MCTLW = rates[rate].mctlw;
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+    if(rx_dma)
+    {
+        UCA0IE = 0;                                 // UCA0RXIFG is for the DMA
+    }
+    else
+    {
+        UCA0IE = UCRXIE;
+    }
+
+    now->char_cycles = (CPU_HZ * BITS_PER_CHAR) / rates[rate].baud;
+    idle_cycles = now->char_cycles * IDLE_CHARS;
+}
+
+void rx_dma_init(void)
+{
+    DMA0CTL = 0;
+    DMACTL0 = DMA0TSEL_14;                          // UCA0RXIFG
+    __data20_write_long((unsigned long)&DMA0SA, (unsigned long)&UCA0RXBUF);
+    __data20_write_long((unsigned long)&DMA0DA, (unsigned long)rx_ring);
+    DMA0SZ = RING_SIZE;
+    DMA0CTL = DMADT_4 | DMASRCINCR_0 | DMADSTINCR_3 | DMASRCBYTE | DMADSTBYTE | DMAEN; // Round and round
+}
+
+#pragma vector=USCI_A0_VECTOR
+__interrupt void UART_RX_ISR(void)
+{
+    unsigned int start = TA1R;
+    unsigned int status;
+    unsigned char data;
+    unsigned char next;
+
+    switch(__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG))
+    {
+        case USCI_UART_UCRXIFG:
+        {
+            status = UCA0STATW;                     // Before UCA0RXBUF clears it
+            data = UCA0RXBUF;
+
+            TA1CCR0 = TA1R + idle_cycles;           // Idle if nothing comes before this
+            TA1CCTL0 = CCIE;
+
+            if(status & UCOE)                       // One was lost, this one is good
+            {
+                now->overruns = now->overruns + 1;
+            }
+            if(status & UCBRK)                      // A break also has UCFE
+            {
+                now->breaks = now->breaks + 1;
+                break;
+            }
+            if(status & UCFE)
+            {
+                now->framing = now->framing + 1;
+                break;
+            }
+            if(status & UCPE)
+            {
+                now->parity = now->parity + 1;
+                break;
+            }
+
+            next = (rx_head + 1) & (RING_SIZE - 1);
+            if(next == rx_tail)
+            {
+                now->ring_full = now->ring_full + 1;
+                break;
+            }
+            rx_ring[rx_head] = data;
+            rx_head = next;
+            break;
+        }
+    }
+
+    start = TA1R - start;
+    if(start > rx_isr_worst)
+    {
+        rx_isr_worst = start;
+    }
+}
+
+// ****************************************************
+// Timer1 ISR - the line has been quiet for IDLE_CHARS
+// ****************************************************
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void Idle_ISR(void)
+{
+    TA1CCTL0 = 0;                                   // Until the next byte
+    now->idles = now->idles + 1;
+}
+
+// ****************************************************
+// Timer2 ISR - a busy program that keeps the RX ISR out
+// ****************************************************
+#pragma vector=TIMER2_A0_VECTOR
+__interrupt void Load_ISR(void)
+{
+    unsigned int start = TA1R;
+    unsigned int late = TA2R;                       // Cycles since Timer2 got to TA2CCR0
+
+    __delay_cycles(LOAD_CYCLES);
+
+    start = (TA1R - start) + late;
+    if(start > load_isr_worst)
+    {
+        load_isr_worst = start;
+    }
+}
+
+// ******************************
+// eUSCI_A1 - the line, with noise
+// ******************************
+void line_init(unsigned char rate)
+{
+    UCA1CTLW0 = UCSWRST;
+    UCA1CTLW0 = UCA1CTLW0 | UART_CLK_SEL | UCPEN | UCPAR; // Even parity
+    UCA1BRW = rates[rate].brw;
+    UCA1MCTLW = rates[rate].mctlw;
+    UCA1CTLW0 = UCA1CTLW0 & (~UCSWRST);
+}
+
+void line_put(unsigned char data)
+{
+    while(!(UCA1IFG & UCTXIFG));                    // Wait for room
+    UCA1TXBUF = data;
+}
+
+void line_put_bad_parity(unsigned char data)
+{
+    while(UCA1STATW & UCBUSY);                      // Everything before it has gone
+    UCA1CTLW0 = UCA1CTLW0 | UCSWRST;
+    UCA1CTLW0 = UCA1CTLW0 & ~UCPAR;                 // Odd - wrong
+    UCA1CTLW0 = UCA1CTLW0 & ~UCSWRST;
+    line_put(data);
+    while(UCA1STATW & UCBUSY);
+    UCA1CTLW0 = UCA1CTLW0 | UCSWRST;
+    UCA1CTLW0 = UCA1CTLW0 | UCPAR;                  // Even again
+    UCA1CTLW0 = UCA1CTLW0 & ~UCSWRST;
+}
+
+void line_put_break(void)
+{
+    while(!(UCA1IFG & UCTXIFG));
+    UCA1CTLW0 = UCA1CTLW0 | UCTXBRK;                // The next byte is a break...
+    UCA1TXBUF = 0x00;                               // ...which must be 0 outside UCMODE_3
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
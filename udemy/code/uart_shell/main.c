@@ -0,0 +1,246 @@
+/*
+ * Changing a running program from the UART with shell.h
+ *
+ * timer0_isr blinks the red LED with TA0CCR0 = 40000, and to blink it at another speed
+ * the program has to be changed and flashed again. Here the same LED blinks, and the
+ * shell (see shell.h) lets us look at and change the program while it runs. Connect a
+ * terminal at 9600 baud and try:
+ *
+ *      period 10000            four times as fast
+ *      rdb 0x0202              P1OUT
+ *      wrb 0x0282 0x80         P9OUT - the green LED on
+ *      stats
+ *
+ * SELF TEST AND BENCHMARK
+ * -----------------------
+ * Before the UART interrupt is turned on, test_lines[] are "typed" into the shell one
+ * character at a time through shell_receive() - the same function the UART ISR uses -
+ * with the output caught in a buffer. Each answer must be exactly what test_lines[]
+ * says, and the command table must have every command in its hash slot. test_errors
+ * counts what was wrong (0 - the green LED is on for a moment).
+ *
+ * Timer1 (1 count = 1 cycle at 8MHz) times shell_lookup() for every command
+ * (lookup_worst_cycles) and the whole "rd 0x0354" line (line_cycles).
+ */
+
+#include <msp430.h>
+#include "shell.h"
+
+#define ENABLE_PINS             0xFFFE              // Required to use inputs and outputs
+#define ACLK                    0x0100              // Timer_A ACLK source
+#define SMCLK                   0x0200              // Timer_A SMCLK source
+#define UP                      0x0010              // Timer_A UP mode
+#define CONTINUOUS              0x0020              // Timer_A CONTINUOUS mode
+#define UART_CLK_SEL            0x0080              // Specifies accurate clock for UART peripheral
+#define BR0_FOR_9600            0x34                // Value required to use 9600 baud
+#define BR1_FOR_9600            0x00                // Value required to use 9600 baud
+#define CLK_MOD                 0x4911              // uC will "clean up" clock signal
+#define TEST_LINES              8
+#define OUTPUT_SIZE             64
+
+// Typed in, and what must come back (echo, answer and the next prompt)
+const char *const test_lines[TEST_LINES][2] =
+{
+    {"period 20000",        "period 20000\r\nTA0CCR0 = 20000\r\n> "},
+    {"wr 0x0354 0xBEEF",    "wr 0x0354 0xBEEF\r\n> "},  // TA0CCR1 - not used here
+    {"rd 0x0354",           "rd 0x0354\r\n0xBEEF\r\n> "},
+    {"rd 0x0355",           "rd 0x0355\r\nbad address\r\n> "},
+    {"frob",                "frob\r\nunknown command\r\n> "},
+    {"wr 0x0354",           "wr 0x0354\r\nusage: wr <addr> <value>\r\n> "},
+    {"sleep 7",             "sleep 7\r\n0 to 3\r\n> "},
+    {"period 40000",        "period 40000\r\nTA0CCR0 = 40000\r\n> "}
+};
+
+// ********************
+// Function Definitions
+// ********************
+void select_clock_signals(void);                    // Assigns uC clock signals
+void assign_pins_to_uart(void);                     // P4.2 is for TXD, P4.3 is for RXD
+void use_9600_baud(void);                           // UART operates at 9600 bits per second
+void run_self_test(void);
+unsigned char same_text(const char *a, const char *b);
+
+char output[OUTPUT_SIZE];
+unsigned char test_errors;
+unsigned int lookup_worst_cycles;
+unsigned int line_cycles;
+
+//*********************
+// Main function
+//*********************
+main()
+{
+    WDTCTL = WDTPW | WDTHOLD;                       // Stop WDT
+    PM5CTL0 = ENABLE_PINS;                          // Enable inputs and outputs
+
+    P1DIR = BIT0;                                   // Red LED
+    P9DIR = BIT7;                                   // Green LED
+    P1OUT = 0x00;
+    P9OUT = 0x00;
+
+    select_clock_signals();                         // SMCLK = 8MHz
+    assign_pins_to_uart();
+    use_9600_baud();
+
+    TA0CCR0 = 40000;                                // The LED - "period" changes this
+    TA0CTL = ACLK | UP | TACLR;
+    TA0CCTL0 = CCIE;
+
+    run_self_test();
+    if(test_errors == 0)
+    {
+        P9OUT = BIT7;                               // Green LED - passed
+    }
+
+    shell_puts("\r\n> ");
+    UCA0IE = UCRXIE;
+
+    while(1)
+    {
+        _BIC_SR(GIE);
+        if(!shell_ready)
+        {
+            _BIS_SR(shell_lpm_bits | GIE);          // "sleep" can make this deeper
+            shell_lpm_bits = LPM0_bits;             // ...but only once
+        }
+        _BIS_SR(GIE);
+
+        if(shell_ready)
+        {
+            shell_run();
+        }
+    }
+}
+
+// ****************************************************
+// Self test and benchmark - lines typed in by the program
+// ****************************************************
+void run_self_test(void)
+{
+    unsigned char i;
+    unsigned char slot;
+    unsigned int start;
+    unsigned int cycles;
+
+    test_errors = shell_check_table();
+
+    for(i = 0; i < TEST_LINES; i = i + 1)
+    {
+        shell_capture = output;
+        shell_capture_end = output + OUTPUT_SIZE - 1;
+        output[0] = 0;
+        shell_line(test_lines[i][0]);
+        if(!same_text(output, test_lines[i][1]))
+        {
+            test_errors = test_errors + 1;
+        }
+    }
+    if(TA0CCR1 != 0xBEEF)                           // The "wr" really wrote
+    {
+        test_errors = test_errors + 1;
+    }
+    if((shell_stats.lines != TEST_LINES) || (shell_stats.unknown != 1) || (shell_stats.bad_args != 3))
+    {
+        test_errors = test_errors + 1;
+    }
+
+    TA1CTL = SMCLK | CONTINUOUS | TACLR;            // 1 count = 1 cycle
+    for(slot = 0; slot < SHELL_SLOTS; slot = slot + 1)
+    {
+        if(shell_commands[slot].name)
+        {
+            start = TA1R;
+            if(shell_lookup(shell_commands[slot].name) != &shell_commands[slot])
+            {
+                test_errors = test_errors + 1;
+            }
+            cycles = TA1R - start;
+            if(cycles > lookup_worst_cycles)
+            {
+                lookup_worst_cycles = cycles;
+            }
+        }
+    }
+    shell_capture = output;
+    start = TA1R;
+    shell_line("rd 0x0354");
+    line_cycles = TA1R - start;
+    TA1CTL = 0;
+
+    shell_capture = 0;                              // The UART from now on
+    shell_stats.lines = 0;
+    shell_stats.unknown = 0;
+    shell_stats.bad_args = 0;
+    shell_stats.lost = 0;
+}
+
+unsigned char same_text(const char *a, const char *b)
+{
+    while(*a && (*a == *b))
+    {
+        a = a + 1;
+        b = b + 1;
+    }
+    return *a == *b;
+}
+
+// *************************************************************************
+// Timer0 ISR - the program being changed
+// *************************************************************************
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer0_ISR(void)
+{
+    P1OUT = P1OUT ^ BIT0;                           // Toggles red LED
+}
+
+// ************************************************************************
+// UART ISR - every character to the shell
+// ***********************************************************************
+#pragma vector=USCI_A0_VECTOR
+__interrupt void UART_ISR(void)
+{
+    switch(__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG))
+    {
+        case USCI_UART_UCRXIFG:
+        {
+            shell_receive(UCA0RXBUF);
+            if(shell_ready)
+            {
+                __bic_SR_register_on_exit(LPM4_bits); // Wake up main() from any "sleep"
+            }
+            break;
+        }
+    }
+}
+
+// *********************
+// Functions
+// *********************
+void select_clock_signals(void)
+{
+    CSCTL0 = 0xA500;                    // "Password" to access clock calibration registers
+    CSCTL1 = 0x0046;                    // Specifies frequency of the main clock
+    CSCTL2 = 0x0133;                    // Assigns additional clock signals
+    CSCTL3 = 0x0000;                    // Use clocks at intended freq, do not slow them down
+}
+
+void assign_pins_to_uart(void)
+{
+    P4SEL1 = 0x00;                      // 0000 0000
+    P4SEL0 = BIT3 | BIT2;               // 0000 1100
+                                        //      ^^
+                                        //      ||
+                                        //      |+----- 01 assigns P4.2 to UART Transmit (TXD)
+                                        //      |
+                                        //      +------ 01 assigns P4.3 to UART Receive (RXD)
+}
+
+void use_9600_baud(void)
+{
+    UCA0CTLW0 = UCSWRST;                            // Puts UART into SoftWare ReSeT
+    UCA0CTLW0 = UCA0CTLW0 | UART_CLK_SEL;           // Specifies clock source for UART
+    UCA0BR0 = BR0_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0BR1 = BR1_FOR_9600;                         // Specifies bit rate of 9600
+    UCA0MCTLW = CLK_MOD;                            // "Cleans" clock signal
+    UCA0CTLW0 = UCA0CTLW0 & (~UCSWRST);             // Takes UART out of SoftWare ReSeT
+}
@@ -0,0 +1,493 @@
+/*
+ * shell.c - line editing, the command table and the built-in commands for shell.h
+ */
+
+#include <msp430.h>
+#include "shell.h"
+
+static void cmd_help(char *argv[]);
+static void cmd_rd(char *argv[]);
+static void cmd_rdb(char *argv[]);
+static void cmd_wr(char *argv[]);
+static void cmd_wrb(char *argv[]);
+static void cmd_period(char *argv[]);
+static void cmd_stats(char *argv[]);
+static void cmd_sleep(char *argv[]);
+static unsigned char get_address(char *text, unsigned int *address, unsigned char word);
+static unsigned char get_value(char *text, unsigned int *value);
+static unsigned char same(const char *a, const char *b);
+
+// Each command in slot SHELL_HASH(first letter, last letter, length)
+const struct shell_command shell_commands[SHELL_SLOTS] =
+{
+    {"stats",  0, cmd_stats,  ""},                  //  0
+    {0},                                            //  1
+    {0},                                            //  2
+    {0},                                            //  3
+    {"rd",     1, cmd_rd,     "<addr>"},            //  4
+    {"rdb",    1, cmd_rdb,    "<addr>"},            //  5
+    {"period", 1, cmd_period, "<counts>"},          //  6
+    {0},                                            //  7
+    {"sleep",  1, cmd_sleep,  "<0-3>"},             //  8
+    {"wr",     2, cmd_wr,     "<addr> <value>"},    //  9
+    {"wrb",    2, cmd_wrb,    "<addr> <value>"},    // 10
+    {0},                                            // 11
+    {"help",   0, cmd_help,   ""},                  // 12
+    {0},                                            // 13
+    {0},                                            // 14
+    {0}                                             // 15
+};
+
+const unsigned int lpm_bits[4] = {LPM0_bits, LPM1_bits, LPM2_bits, LPM3_bits};
+const unsigned int powers_of_ten[5] = {10000, 1000, 100, 10, 1};
+
+struct shell_stats shell_stats;
+volatile unsigned char shell_ready;
+unsigned int shell_lpm_bits = LPM0_bits;
+char *shell_capture;
+char *shell_capture_end;
+
+static char buffer[SHELL_LINE];
+static unsigned char length;
+
+// ******************************
+// Characters in (UART ISR)
+// ******************************
+void shell_receive(unsigned char c)
+{
+    if(shell_ready)                                 // main() has not run the last line yet
+    {
+        shell_stats.lost = shell_stats.lost + 1;
+        return;
+    }
+
+    if((c == '\r') || (c == '\n'))
+    {
+        if(length > 0)                              // "\r\n" is one Enter, not two
+        {
+            buffer[length] = 0;
+            length = 0;
+            shell_puts("\r\n");
+            shell_ready = 1;
+        }
+    }
+    else if((c == '\b') || (c == 0x7F))             // Backspace or Delete
+    {
+        if(length > 0)
+        {
+            length = length - 1;
+            shell_puts("\b \b");
+        }
+    }
+    else if(length < SHELL_LINE - 1)
+    {
+        buffer[length] = c;
+        length = length + 1;
+        shell_put(c);                               // Echo
+    }
+    else
+    {
+        shell_stats.lost = shell_stats.lost + 1;
+    }
+}
+
+void shell_line(const char *text)
+{
+    while(*text)
+    {
+        shell_receive(*text);
+        text = text + 1;
+    }
+    shell_receive('\r');
+    if(shell_ready)
+    {
+        shell_run();
+    }
+}
+
+// ******************************
+// A whole line (main)
+// ******************************
+void shell_run(void)
+{
+    char *argv[SHELL_MAX_ARGS];
+    unsigned char argc = 0;
+    char *p = buffer;
+    const struct shell_command *command;
+
+    while(*p)                                       // Words, in place
+    {
+        while(*p == ' ')
+        {
+            *p = 0;
+            p = p + 1;
+        }
+        if(*p == 0)
+        {
+            break;
+        }
+        if(argc == SHELL_MAX_ARGS)
+        {
+            argc = argc + 1;                        // Too many - the count will be wrong
+            break;
+        }
+        argv[argc] = p;
+        argc = argc + 1;
+        while((*p != ' ') && (*p != 0))
+        {
+            p = p + 1;
+        }
+    }
+
+    shell_stats.lines = shell_stats.lines + 1;
+
+    if(argc > 0)
+    {
+        command = shell_lookup(argv[0]);
+        if(command == 0)
+        {
+            shell_stats.unknown = shell_stats.unknown + 1;
+            shell_puts("unknown command\r\n");
+        }
+        else if(argc != command->args + 1)
+        {
+            shell_stats.bad_args = shell_stats.bad_args + 1;
+            shell_puts("usage: ");
+            shell_puts(command->name);
+            shell_put(' ');
+            shell_puts(command->help);
+            shell_puts("\r\n");
+        }
+        else
+        {
+            command->run(argv);
+        }
+    }
+
+    shell_puts("> ");
+    shell_ready = 0;
+}
+
+const struct shell_command *shell_lookup(const char *name)
+{
+    const struct shell_command *command;
+    unsigned char n = 0;
+
+    while(name[n])
+    {
+        n = n + 1;
+    }
+    if(n == 0)
+    {
+        return 0;
+    }
+
+    command = &shell_commands[SHELL_HASH(name[0], name[n - 1], n)];
+    if(command->name && same(command->name, name))
+    {
+        return command;
+    }
+    return 0;
+}
+
+unsigned char shell_check_table(void)
+{
+    unsigned char slot;
+    unsigned char n;
+    unsigned char errors = 0;
+    const char *name;
+
+    for(slot = 0; slot < SHELL_SLOTS; slot = slot + 1)
+    {
+        name = shell_commands[slot].name;
+        if(name)
+        {
+            n = 0;
+            while(name[n])
+            {
+                n = n + 1;
+            }
+            if(SHELL_HASH(name[0], name[n - 1], n) != slot)
+            {
+                errors = errors + 1;
+            }
+        }
+    }
+    return errors;
+}
+
+static unsigned char same(const char *a, const char *b)
+{
+    while(*a && (*a == *b))
+    {
+        a = a + 1;
+        b = b + 1;
+    }
+    return *a == *b;
+}
+
+// ******************************
+// Numbers and output
+// ******************************
+unsigned char shell_number(const char *text, unsigned int *value)
+{
+    unsigned int result = 0;
+    unsigned char digit;
+
+    if((text[0] == '0') && ((text[1] == 'x') || (text[1] == 'X')))
+    {
+        text = text + 2;
+        if(*text == 0)
+        {
+            return 0;
+        }
+        while(*text)
+        {
+            if((*text >= '0') && (*text <= '9'))
+            {
+                digit = *text - '0';
+            }
+            else if((*text >= 'a') && (*text <= 'f'))
+            {
+                digit = *text - 'a' + 10;
+            }
+            else if((*text >= 'A') && (*text <= 'F'))
+            {
+                digit = *text - 'A' + 10;
+            }
+            else
+            {
+                return 0;
+            }
+            if(result > 0x0FFF)                     // Would not fit in 16 bits
+            {
+                return 0;
+            }
+            result = (result << 4) | digit;
+            text = text + 1;
+        }
+    }
+    else
+    {
+        if(*text == 0)
+        {
+            return 0;
+        }
+        while(*text)
+        {
+            if((*text < '0') || (*text > '9'))
+            {
+                return 0;
+            }
+            digit = *text - '0';
+            if((result > 6553) || ((result == 6553) && (digit > 5)))
+            {
+                return 0;
+            }
+            result = (result << 3) + (result << 1) + digit; // * 10
+            text = text + 1;
+        }
+    }
+    *value = result;
+    return 1;
+}
+
+void shell_put(char c)
+{
+    if(shell_capture)                               // Self test - into a buffer
+    {
+        if(shell_capture < shell_capture_end)
+        {
+            *shell_capture = c;
+            shell_capture = shell_capture + 1;
+            *shell_capture = 0;
+        }
+        return;
+    }
+    while(!(UCA0IFG & UCTXIFG));                    // Wait for room
+    UCA0TXBUF = c;
+}
+
+void shell_puts(const char *text)
+{
+    while(*text)
+    {
+        shell_put(*text);
+        text = text + 1;
+    }
+}
+
+void shell_put_hex(unsigned int value)
+{
+    signed char shift;
+    unsigned char digit;
+
+    shell_puts("0x");
+    for(shift = 12; shift >= 0; shift = shift - 4)
+    {
+        digit = (value >> shift) & 0x0F;
+        shell_put(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    }
+}
+
+void shell_put_dec(unsigned int value)
+{
+    unsigned char i;
+    char digit;
+    unsigned char started = 0;
+
+    for(i = 0; i < 5; i = i + 1)                    // Subtract, no division
+    {
+        digit = '0';
+        while(value >= powers_of_ten[i])
+        {
+            value = value - powers_of_ten[i];
+            digit = digit + 1;
+        }
+        if((digit != '0') || started || (i == 4))
+        {
+            shell_put(digit);
+            started = 1;
+        }
+    }
+}
+
+// ******************************
+// Built-in commands
+// ******************************
+static unsigned char get_address(char *text, unsigned int *address, unsigned char word)
+{
+    if(!shell_number(text, address) || (word && (*address & 1)))
+    {
+        shell_stats.bad_args = shell_stats.bad_args + 1;
+        shell_puts("bad address\r\n");
+        return 0;
+    }
+    return 1;
+}
+
+static unsigned char get_value(char *text, unsigned int *value)
+{
+    if(!shell_number(text, value))
+    {
+        shell_stats.bad_args = shell_stats.bad_args + 1;
+        shell_puts("bad number\r\n");
+        return 0;
+    }
+    return 1;
+}
+
+static void cmd_help(char *argv[])
+{
+    unsigned char slot;
+
+    for(slot = 0; slot < SHELL_SLOTS; slot = slot + 1)
+    {
+        if(shell_commands[slot].name)
+        {
+            shell_puts(shell_commands[slot].name);
+            shell_put(' ');
+            shell_puts(shell_commands[slot].help);
+            shell_puts("\r\n");
+        }
+    }
+}
+
+static void cmd_rd(char *argv[])
+{
+    unsigned int address;
+
+    if(get_address(argv[1], &address, 1))
+    {
+        shell_put_hex(*(volatile unsigned int *)address);
+        shell_puts("\r\n");
+    }
+}
+
+static void cmd_rdb(char *argv[])
+{
+    unsigned int address;
+
+    if(get_address(argv[1], &address, 0))
+    {
+        shell_put_hex(*(volatile unsigned char *)address);
+        shell_puts("\r\n");
+    }
+}
+
+static void cmd_wr(char *argv[])
+{
+    unsigned int address;
+    unsigned int value;
+
+    if(get_address(argv[1], &address, 1) && get_value(argv[2], &value))
+    {
+        *(volatile unsigned int *)address = value;
+    }
+}
+
+static void cmd_wrb(char *argv[])
+{
+    unsigned int address;
+    unsigned int value;
+
+    if(get_address(argv[1], &address, 0) && get_value(argv[2], &value))
+    {
+        *(volatile unsigned char *)address = value;
+    }
+}
+
+static void cmd_period(char *argv[])
+{
+    unsigned int value;
+
+    if(!get_value(argv[1], &value))
+    {
+        return;
+    }
+    if(value == 0)
+    {
+        shell_stats.bad_args = shell_stats.bad_args + 1;
+        shell_puts("1 to 65535\r\n");
+    }
+    else
+    {
+        TA0CCR0 = value;
+        if(TA0R >= value)                           // Past the new end - start the count again
+        {
+            TA0CTL = TA0CTL | TACLR;
+        }
+        shell_puts("TA0CCR0 = ");
+        shell_put_dec(TA0CCR0);
+        shell_puts("\r\n");
+    }
+}
+
+static void cmd_stats(char *argv[])
+{
+    shell_puts("lines ");
+    shell_put_dec(shell_stats.lines);
+    shell_puts("\r\nunknown ");
+    shell_put_dec(shell_stats.unknown);
+    shell_puts("\r\nbad_args ");
+    shell_put_dec(shell_stats.bad_args);
+    shell_puts("\r\nlost ");
+    shell_put_dec(shell_stats.lost);
+    shell_puts("\r\n");
+}
+
+static void cmd_sleep(char *argv[])
+{
+    unsigned int value;
+
+    if(get_value(argv[1], &value))
+    {
+        if(value > 3)
+        {
+            shell_stats.bad_args = shell_stats.bad_args + 1;
+            shell_puts("0 to 3\r\n");
+            return;
+        }
+        shell_lpm_bits = lpm_bits[value];           // main() uses it for the next wait
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * shell.h - a small command line on the UART
+ *
+ * Type a command and press Enter (9600 baud, P4.2 / P4.3):
+ *
+ *      help                    the list below
+ *      rd <addr>               read a 16-bit register, e.g. "rd 0x0340" is TA0CTL
+ *      rdb <addr>              read an 8-bit register, e.g. "rdb 0x0202" is P1OUT
+ *      wr <addr> <value>       write a 16-bit register
+ *      wrb <addr> <value>      write an 8-bit register
+ *      period <counts>         TA0CCR0 - how often the program's timer runs
+ *      stats                   lines, unknown commands, bad arguments, lost characters
+ *      sleep <0-3>             the next wait is in LPM0 to LPM3 (a key wakes it up)
+ *
+ * Numbers can be decimal (40000) or hex (0x9C40).
+ *
+ * HOW IT WORKS
+ * ------------
+ * The UART ISR gives every character to shell_receive(). It is echoed and kept in
+ * shell_line[] until Enter, then shell_ready is set and main() calls shell_run(). Until
+ * then new characters are thrown away (and counted in stats.lost).
+ *
+ * shell_run() cuts the line into words IN PLACE (each space becomes a 0) and keeps a
+ * pointer to each word in argv[] - there is no malloc and the stack use is fixed.
+ *
+ * The command table shell_commands[] is const (it stays in FRAM) and it is ALSO the hash
+ * table: each command sits in slot SHELL_HASH(first letter, last letter, length), so
+ * finding a command is one hash and one string compare, however many commands there
+ * are. No two commands may share a slot (a "perfect" hash) - shell_check_table() finds
+ * out if one was put in the wrong place.
+ *
+ * SIZE
+ * ----
+ * The shell is meant to fit in 2KB of FRAM. To check it, build the project and look
+ * for shell.obj in the MODULE SUMMARY of the .map file (Debug/uart_shell.map): the code
+ * and const columns added together are what the shell takes. shell_commands[], the
+ * help strings and the names are all const, so they count too. The RAM is the line
+ * buffer (SHELL_LINE), shell_stats and a few pointers - about 50 bytes.
+ */
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#include <msp430.h>
+
+#define SHELL_LINE              32                  // Longest line, with its 0
+#define SHELL_MAX_ARGS          4                   // Command word included
+#define SHELL_SLOTS             16                  // Must be a power of 2
+
+#define SHELL_HASH(first, last, length) (((first) + ((last) << 3) + (length)) & (SHELL_SLOTS - 1))
+
+struct shell_command
+{
+    const char *name;                               // 0 - empty slot
+    unsigned char args;                             // Words after the command
+    void (*run)(char *argv[]);
+    const char *help;
+};
+
+struct shell_stats
+{
+    unsigned int lines;
+    unsigned int unknown;                           // No such command
+    unsigned int bad_args;                          // Wrong number of words or not a number
+    unsigned int lost;                              // Characters while busy or past SHELL_LINE
+};
+
+extern const struct shell_command shell_commands[SHELL_SLOTS];
+extern struct shell_stats shell_stats;
+extern volatile unsigned char shell_ready;          // A line is waiting for shell_run()
+extern unsigned int shell_lpm_bits;                 // What main() should sleep in next
+extern char *shell_capture;                         // Not 0 - output goes here, not the UART...
+extern char *shell_capture_end;                     // ...up to here
+
+void shell_receive(unsigned char c);                // From the UART ISR
+void shell_run(void);                               // From main() when shell_ready is 1
+void shell_line(const char *text);                  // A whole line, as if it was typed
+const struct shell_command *shell_lookup(const char *name);
+unsigned char shell_check_table(void);              // Commands in the wrong slot
+
+unsigned char shell_number(const char *text, unsigned int *value); // 0 - not a number
+void shell_put(char c);
+void shell_puts(const char *text);
+void shell_put_hex(unsigned int value);             // Always 0x and 4 digits
+void shell_put_dec(unsigned int value);
+
+#endif /* SHELL_H_ */